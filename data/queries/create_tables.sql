@@ -55,6 +55,16 @@ WHERE NOT EXISTS (
       AND f_geometry_column = 'geom'
 );
 
+CREATE TABLE IF NOT EXISTS depth_grids (
+    id          INTEGER PRIMARY KEY AUTOINCREMENT,
+    created_at  TEXT DEFAULT CURRENT_TIMESTAMP NOT NULL,
+    min_lat     REAL NOT NULL,
+    min_lon     REAL NOT NULL,
+    cell_size   REAL NOT NULL,
+    n_rows      INTEGER NOT NULL,
+    n_cols      INTEGER NOT NULL
+);
+
 CREATE TABLE IF NOT EXISTS safe_points (
     id      INTEGER PRIMARY KEY AUTOINCREMENT,
     created_at TEXT DEFAULT CURRENT_TIMESTAMP NOT NULL,
@@ -70,3 +80,54 @@ WHERE NOT EXISTS (
     WHERE f_table_name = 'safe_points' 
       AND f_geometry_column = 'geom'
 );
+
+CREATE TABLE IF NOT EXISTS shoal_polygons (
+    id          INTEGER PRIMARY KEY AUTOINCREMENT,
+    created_at  TEXT DEFAULT CURRENT_TIMESTAMP NOT NULL,
+    draft       REAL NOT NULL
+);
+
+CREATE INDEX IF NOT EXISTS idx_shoal_polygons_draft
+ON shoal_polygons (draft);
+
+SELECT AddGeometryColumn(
+    'shoal_polygons', 'geom', 4326, 'MULTIPOLYGON', 'XY'
+), CreateSpatialIndex('shoal_polygons', 'geom')
+WHERE NOT EXISTS (
+    SELECT 1 
+    FROM geometry_columns 
+    WHERE f_table_name = 'shoal_polygons' 
+      AND f_geometry_column = 'geom'
+);
+
+CREATE TABLE IF NOT EXISTS scan_results (
+    id            INTEGER PRIMARY KEY AUTOINCREMENT,
+    created_at    TEXT DEFAULT CURRENT_TIMESTAMP NOT NULL,
+    scan_key      TEXT NOT NULL UNIQUE,
+    result        INTEGER NOT NULL
+);
+
+CREATE TABLE IF NOT EXISTS scan_result_hazards (
+    id              INTEGER PRIMARY KEY AUTOINCREMENT,
+    scan_result_id  INTEGER NOT NULL,
+    check_time      INTEGER NOT NULL,
+    expected_time   INTEGER NOT NULL,
+    last_expected_time INTEGER NOT NULL,
+    reason          INTEGER NOT NULL,
+    value           REAL NOT NULL,
+    hazard_count    INTEGER NOT NULL,
+    FOREIGN KEY(scan_result_id) REFERENCES scan_results(id)
+);
+
+CREATE INDEX IF NOT EXISTS idx_scan_result_hazards_scan_result_id
+ON scan_result_hazards (scan_result_id);
+
+SELECT AddGeometryColumn(
+    'scan_result_hazards', 'geom', 4326, 'POINT', 'XY'
+)
+WHERE NOT EXISTS (
+    SELECT 1 
+    FROM geometry_columns 
+    WHERE f_table_name = 'scan_result_hazards' 
+      AND f_geometry_column = 'geom'
+);
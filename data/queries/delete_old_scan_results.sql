@@ -0,0 +1,7 @@
+-- kDeleteOldScanResults
+
+DELETE FROM scan_result_hazards
+WHERE scan_result_id IN (SELECT id FROM scan_results ORDER BY id DESC LIMIT -1 OFFSET $1);
+
+DELETE FROM scan_results
+WHERE id IN (SELECT id FROM scan_results ORDER BY id DESC LIMIT -1 OFFSET $1);
@@ -0,0 +1,6 @@
+-- kDeleteScanResult
+
+DELETE FROM scan_result_hazards
+WHERE scan_result_id IN (SELECT id FROM scan_results WHERE scan_key = $1);
+
+DELETE FROM scan_results WHERE scan_key = $1;
@@ -0,0 +1,4 @@
+-- kDeleteScanResults
+
+DELETE FROM scan_result_hazards;
+DELETE FROM scan_results;
@@ -0,0 +1,4 @@
+-- kInsertDepthGrid
+
+INSERT INTO depth_grids (min_lat, min_lon, cell_size, n_rows, n_cols)
+VALUES ($1, $2, $3, $4, $5);
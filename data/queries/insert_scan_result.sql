@@ -0,0 +1,5 @@
+-- kInsertScanResult
+
+INSERT INTO scan_results (scan_key, result)
+VALUES ($1, $2)
+RETURNING id;
@@ -0,0 +1,4 @@
+-- kInsertScanResultHazards
+
+INSERT INTO scan_result_hazards (scan_result_id, check_time, expected_time, last_expected_time, reason, value, hazard_count, geom)
+VALUES $1;
@@ -0,0 +1,12 @@
+-- kInsertShoalPolygons
+
+SELECT load_extension('mod_spatialite');
+
+WITH shoals(draft, wkt, tolerance) AS (
+    VALUES $1
+)
+INSERT INTO shoal_polygons (draft, geom)
+SELECT 
+    draft, 
+    CastToMultiPolygon(ST_Buffer(GeomFromText(wkt, 4326), CAST(tolerance AS REAL)))
+FROM shoals;
@@ -0,0 +1,5 @@
+-- kSelectDepthGrids
+
+SELECT id, min_lat, min_lon, cell_size, n_rows, n_cols
+FROM depth_grids
+ORDER BY id ASC;
@@ -0,0 +1,6 @@
+-- kSelectForecastLatitudes
+
+SELECT DISTINCT ST_Y(geom) AS lat
+FROM forecast_records
+WHERE forecast_id = $1
+ORDER BY lat;
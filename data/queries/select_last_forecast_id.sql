@@ -0,0 +1,3 @@
+-- kSelectLastForecastId
+
+SELECT COALESCE(MAX(id), 0) FROM forecasts;
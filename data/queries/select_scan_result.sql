@@ -0,0 +1,7 @@
+-- kSelectScanResult
+
+SELECT r.result, ST_AsText(h.geom) as geom, h.check_time, h.expected_time, h.last_expected_time, h.reason, h.value, h.hazard_count
+FROM scan_results r
+LEFT JOIN scan_result_hazards h ON h.scan_result_id = r.id
+WHERE r.scan_key = $1
+ORDER BY h.id;
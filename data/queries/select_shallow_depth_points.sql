@@ -0,0 +1,8 @@
+-- kSelectShallowDepthPoints
+
+SELECT
+    ST_Y(d.geom) AS lat,
+    ST_X(d.geom) AS lon
+FROM depths d
+WHERE
+    -d.depth <= $1;
@@ -0,0 +1,19 @@
+-- kSelectShallowestDepthPointsInTiles
+
+WITH tiles(id, geom) AS (
+    VALUES $1
+)
+SELECT
+    tiles.id,
+    MAX(d.depth) AS depth,
+    ST_AsText(d.geom) AS geom
+FROM tiles
+INNER JOIN depths d
+ON d.ROWID IN (
+    SELECT ROWID
+    FROM SpatialIndex
+    WHERE f_table_name = 'depths'
+      AND search_frame = tiles.geom
+)
+WHERE ST_Within(d.geom, tiles.geom)
+GROUP BY tiles.id;
@@ -0,0 +1,5 @@
+-- kSelectShoalDraft
+
+SELECT MIN(draft)
+FROM shoal_polygons
+WHERE draft >= $1;
@@ -0,0 +1,14 @@
+-- kSelectShoalPolygonsInZone
+
+SELECT ST_AsText(ST_SimplifyPreserveTopology(
+    ST_Buffer(s.geom, CAST($3 AS REAL)), CAST($4 AS REAL)))
+FROM shoal_polygons s
+WHERE 
+    s.draft = $2
+    AND s.ROWID IN (
+        SELECT ROWID 
+        FROM SpatialIndex 
+        WHERE f_table_name = 'shoal_polygons' 
+          AND search_frame = $1
+    )
+    AND ST_Intersects(s.geom, $1);
@@ -1,31 +1,75 @@
 #include "best_route_maker.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <queue>
 
+#include <wx/log.h>
+
 #include "cases/scorers/iscore.h"
 #include "cases/scorers/time_scorer.h"
 #include "entities/find_route_grid.h"
+#include "entities/quadtree_route_grid.h"
+#include "entities/visibility_graph.h"
 
 namespace marine_navi::cases {
 
 namespace {
 
-entities::FindRouteGrid MakeFindRouteGrid(const BestRouteInput& input) {
-  static constexpr double kStep = 0.1;  // size of grid cell in radians
+constexpr double kStep = 0.1;  // size of grid cell in degrees
+const size_t kMaxVisibilityVertexCount = 500;
+const int kQuadtreeMaxLevel = 3;  // the coarsest quadtree cell is 2^3 grid steps
+// the uniform grid refuses to build more vertices, see FindRouteGrid
+const size_t kMaxUniformVertexCount = 10000;
+const size_t kMaxWeatherSampleCount = 10000;
+constexpr double kMinForecastRad = 0.1;
+// straight edges ignore weather between their ends, so the grid is used when speed varies more
+constexpr double kMaxSpeedVariation = 0.1;
+
+common::Polygon MakeBoundsPolygon(const BestRouteInput& input) {
   const auto bound_points = input.bounds->GetPoints();
   std::vector<common::Point> points;
 
   for (const auto& bound_point : bound_points) {
     points.push_back(bound_point.point);
   }
-  return entities::FindRouteGrid{common::Polygon{points}, kStep};
+  return common::Polygon{points};
+}
+
+// @return kStep or the smallest multiple of it by a power of two which keeps the uniform zone grid within its
+// vertex limit, so large zones get a coarser grid instead of failing
+double GetUniformStep(const common::Polygon& zone) {
+  double min_lat = zone.Points.at(0).Lat, max_lat = min_lat;
+  double min_lon = zone.Points.at(0).Lon, max_lon = min_lon;
+  for (const auto& point : zone.Points) {
+    min_lat = std::min(min_lat, point.Lat);
+    max_lat = std::max(max_lat, point.Lat);
+    min_lon = std::min(min_lon, point.Lon);
+    max_lon = std::max(max_lon, point.Lon);
+  }
+  double step = kStep;
+  while (((max_lat - min_lat) / step + 2) * ((max_lon - min_lon) / step + 2) > kMaxUniformVertexCount) {
+    step *= 2;
+  }
+  return step;
 }
 
-BestRouteResult MakeBestRouteWithScorer(
-    const entities::FindRouteGrid& find_route_grid, int start_point_id,
+std::vector<common::Segment> MakeCorridor(const BestRouteInput& input) {
+  std::vector<common::Segment> corridor;
+  for (const auto& route_segment : input.route->GetSegments()) {
+    corridor.push_back(route_segment.segment);
+  }
+  return corridor;
+}
+
+// @return std::nullopt if the end point is unreachable
+template <typename Graph>
+std::optional<BestRouteResult> MakeBestRouteWithScorer(
+    const Graph& graph, int start_point_id,
     int end_point_id, std::shared_ptr<scorers::IScorer> scorer) {
 
-  const auto& points = find_route_grid.GetPoints();
+  const auto& points = graph.GetPoints();
 
   std::vector<int64_t> dp(points.size(), scorers::IScorer::kMaxScore);
   std::vector<time_t> expected_time(points.size(), 0);
@@ -50,7 +94,7 @@ BestRouteResult MakeBestRouteWithScorer(
     if (point_id == end_point_id) {
       break;
     }
-    for (const auto& adjency_point_id : find_route_grid.GetAdjencyPointIds(point_id)) {
+    for (const auto& adjency_point_id : graph.GetAdjencyPointIds(point_id)) {
       const auto adjency_point_score = score + scorer->GetScore(point_id, adjency_point_id, depart_time);
       if (dp[adjency_point_id] > adjency_point_score) {
         dp[adjency_point_id] = adjency_point_score;
@@ -61,6 +105,10 @@ BestRouteResult MakeBestRouteWithScorer(
     }
   }
 
+  if (dp[end_point_id] >= scorers::IScorer::kMaxScore) {
+    return std::nullopt;
+  }
+
   std::vector<common::Point> result;
   int point_id = end_point_id;
   while (point_id != -1) {
@@ -70,34 +118,313 @@ BestRouteResult MakeBestRouteWithScorer(
   std::reverse(result.begin(), result.end());
   return BestRouteResult{
       .points = result,
-      .arrival_time = expected_time[end_point_id]
+      .arrival_time = expected_time[end_point_id],
+      .max_time_to_safety = std::nullopt
   };
 }
 
+// Samples weather along every edge of the route at the times the ship is expected there, an edge keeps the speed
+// of its start point, so the route is rejected when speed along an edge differs from it
+bool HasSignificantWeatherVariation(clients::DbClient& db_client, const BestRouteInput& input,
+                                    const std::vector<common::Point>& route_points) {
+  double route_length = 0;
+  for (size_t i = 0; i + 1 < route_points.size(); ++i) {
+    route_length += common::GetHaversineDistance(route_points[i], route_points[i + 1]);
+  }
+  const double sample_step = std::max(kStep * common::kMetersPerDegree, route_length / kMaxWeatherSampleCount);
+
+  // samples of edge i are in [edge_offsets[i], edge_offsets[i + 1]), the first one is the edge start
+  std::vector<common::Point> samples;
+  std::vector<double> sample_distances;
+  std::vector<size_t> edge_offsets;
+  for (size_t i = 0; i + 1 < route_points.size(); ++i) {
+    edge_offsets.push_back(samples.size());
+    const double length = common::GetHaversineDistance(route_points[i], route_points[i + 1]);
+    const size_t count = static_cast<size_t>(std::ceil(length / sample_step));
+    for (size_t j = 0; j < std::max<size_t>(count, 1); ++j) {
+      const double fraction = static_cast<double>(j) / std::max<size_t>(count, 1);
+      samples.push_back(route_points[i] + (route_points[i + 1] - route_points[i]) * fraction);
+      sample_distances.push_back(length * fraction);
+    }
+  }
+  edge_offsets.push_back(samples.size());
+
+  const helpers::ForecastAccessor forecast_accessor(
+      db_client.SelectClosestForecasts(samples, kMinForecastRad, input.depart_time));
+  const auto get_speed = [&](size_t sample_id, time_t time) {
+    const auto forecast = forecast_accessor.GetClosestForecast(static_cast<int>(sample_id), time);
+    return helpers::GetSpeed(input.ship_performance_info, forecast.has_value() ? forecast->GetWaveHeight() : 0);
+  };
+
+  time_t edge_start_time = input.depart_time;
+  for (size_t i = 0; i + 1 < edge_offsets.size(); ++i) {
+    const double edge_speed = get_speed(edge_offsets[i], edge_start_time);
+    for (size_t j = edge_offsets[i] + 1; j < edge_offsets[i + 1]; ++j) {
+      const double speed = get_speed(j, edge_start_time + sample_distances[j] / edge_speed);
+      if (std::max(speed, edge_speed) > std::min(speed, edge_speed) * (1 + kMaxSpeedVariation)) {
+        return true;
+      }
+    }
+    edge_start_time += common::GetHaversineDistance(route_points[i], route_points[i + 1]) / edge_speed;
+  }
+  return false;
+}
+
+// Splits quadtree cells which are close to danger or where speed changes along the cell
+class QuadtreeSplitCriteria {
+public:
+  QuadtreeSplitCriteria(const common::Polygon& zone, const BestRouteInput& input,
+                        std::shared_ptr<const entities::DangerDistanceField> distance_field,
+                        clients::DbClient& db_client)
+      : distance_field_(distance_field) {
+    min_lat_ = max_lat_ = zone.Points.at(0).Lat;
+    min_lon_ = max_lon_ = zone.Points.at(0).Lon;
+    for (const auto& point : zone.Points) {
+      min_lat_ = std::min(min_lat_, point.Lat);
+      max_lat_ = std::max(max_lat_, point.Lat);
+      min_lon_ = std::min(min_lon_, point.Lon);
+      max_lon_ = std::max(max_lon_, point.Lon);
+    }
+
+    // weather is sampled once on a lattice instead of querying forecasts for every cell
+    weather_step_ = 2 * kStep;
+    while (GetRows() * GetCols() > kMaxWeatherSampleCount) {
+      weather_step_ *= 2;
+    }
+    std::vector<common::Point> samples;
+    for (size_t row = 0; row < GetRows(); ++row) {
+      for (size_t col = 0; col < GetCols(); ++col) {
+        samples.push_back(common::Point{min_lat_ + row * weather_step_, min_lon_ + col * weather_step_});
+      }
+    }
+    const helpers::ForecastAccessor forecast_accessor(
+        db_client.SelectClosestForecasts(samples, kMinForecastRad, input.depart_time));
+    std::vector<std::pair<int, time_t>> queries(samples.size());
+    for (size_t i = 0; i < samples.size(); ++i) {
+      queries[i] = {static_cast<int>(i), input.depart_time};
+    }
+    const auto forecasts = forecast_accessor.GetClosestForecasts(queries);
+    speeds_.resize(samples.size());
+    for (size_t i = 0; i < samples.size(); ++i) {
+      speeds_[i] = helpers::GetSpeed(input.ship_performance_info, forecasts[i].has_value() ? forecasts[i]->GetWaveHeight() : 0);
+    }
+  }
+
+  bool NeedSplit(common::Point center, double size) const {
+    if (distance_field_ != nullptr) {
+      const auto distance = distance_field_->GetDistance(center);
+      if (distance.has_value() && distance.value() < size * common::kMetersPerDegree) {
+        return true;
+      }
+    }
+
+    const auto [min_row, max_row] = GetRange(center.Lat - size / 2, center.Lat + size / 2, min_lat_, GetRows());
+    const auto [min_col, max_col] = GetRange(center.Lon - size / 2, center.Lon + size / 2, min_lon_, GetCols());
+    double min_speed = std::numeric_limits<double>::max();
+    double max_speed = 0;
+    for (size_t row = min_row; row <= max_row; ++row) {
+      for (size_t col = min_col; col <= max_col; ++col) {
+        min_speed = std::min(min_speed, speeds_[row * GetCols() + col]);
+        max_speed = std::max(max_speed, speeds_[row * GetCols() + col]);
+      }
+    }
+    return max_speed > min_speed * (1 + kMaxSpeedVariation);
+  }
+
+private:
+  size_t GetRows() const { return static_cast<size_t>((max_lat_ - min_lat_) / weather_step_) + 1; }
+  size_t GetCols() const { return static_cast<size_t>((max_lon_ - min_lon_) / weather_step_) + 1; }
+
+  // @return the closest lattice samples around the range
+  std::pair<size_t, size_t> GetRange(double from, double to, double origin, size_t count) const {
+    const auto clamp = [&](double index) {
+      return static_cast<size_t>(std::clamp(index, 0.0, static_cast<double>(count - 1)));
+    };
+    return {clamp(std::floor((from - origin) / weather_step_)), clamp(std::ceil((to - origin) / weather_step_))};
+  }
+
+private:
+  std::shared_ptr<const entities::DangerDistanceField> distance_field_;
+  double min_lat_, max_lat_, min_lon_, max_lon_;
+  double weather_step_;
+  std::vector<double> speeds_;
+};
+
+std::optional<double> GetMaxTimeToSafety(const helpers::SafetyField& safety_field,
+                                         const std::vector<common::Point>& points) {
+  double result = 0;
+  for (const auto& point : points) {
+    const auto time_to_safety = safety_field.GetTimeToSafety(point);
+    if (!time_to_safety.has_value()) {
+      return std::nullopt;
+    }
+    result = std::max(result, time_to_safety.value());
+  }
+  return result;
+}
+
 }  // namespace
 
-BestRouteMaker::BestRouteMaker(std::shared_ptr<clients::DbClient> db_client)
-    : db_client_(db_client) {}
+BestRouteMaker::BestRouteMaker(std::shared_ptr<clients::DbClient> db_client,
+                               std::shared_ptr<SafePointManager> safe_point_manager,
+                               std::shared_ptr<FindRouteGridCache> find_route_grid_cache,
+                               std::shared_ptr<DepthMaskProvider> depth_mask_provider)
+    : db_client_(db_client),
+      safe_point_manager_(safe_point_manager),
+      find_route_grid_cache_(find_route_grid_cache),
+      depth_mask_provider_(depth_mask_provider) {}
 
 BestRouteResult BestRouteMaker::MakeBestRoute(const BestRouteInput& input) {
-  const auto find_route_grid = MakeFindRouteGrid(input);
+  if (input.route->GetSegments().empty()) {
+    throw std::runtime_error("route must have at least one segment");
+  }
 
-  if (input.route->GetSegments().size() != 1) {
-    std::runtime_error("route must have only one segment");
+  if (auto result = MakeBestRouteOnVisibilityGraph(input); result.has_value()) {
+    return result.value();
   }
-  const auto& route_segment = input.route->GetSegments()[0];
 
-  int start_point_id =
-      find_route_grid.GetClosestPointId(route_segment.segment.Start);
-  int end_point_id =
-      find_route_grid.GetClosestPointId(route_segment.segment.End);
+  if (input.corridor_width.has_value()) {
+    const double buffer = std::max(input.corridor_width.value() / 2 / common::kMetersPerDegree, kStep);
+    // the corridor grid fails when the corridor misses the zone or is too large, the zone is searched then
+    try {
+      auto result = MakeBestRouteOnGrid(
+          find_route_grid_cache_->Get(MakeBoundsPolygon(input), MakeCorridor(input), buffer, kStep), input);
+      if (result.has_value()) {
+        return result.value();
+      }
+      wxLogInfo(_T("No feasible route in corridor, fall back to the whole zone"));
+    } catch (const std::exception& ex) {
+      wxLogInfo(_T("Failed to search the corridor with reason: %s, fall back to the whole zone"), ex.what());
+    }
+  }
+
+  if (auto result = MakeBestRouteOnQuadtree(input); result.has_value()) {
+    return result.value();
+  }
+  wxLogInfo(_T("No feasible route on quadtree grid, fall back to the uniform grid"));
 
-  std::shared_ptr<scorers::IScorer> scorer = std::make_shared<scorers::TimeScorer>(
+  const auto zone = MakeBoundsPolygon(input);
+  auto result = MakeBestRouteOnGrid(find_route_grid_cache_->Get(zone, GetUniformStep(zone)), input);
+  if (!result.has_value()) {
+    throw std::runtime_error("no feasible route in zone");
+  }
+  return result.value();
+}
+
+std::optional<BestRouteResult> BestRouteMaker::MakeBestRouteOnVisibilityGraph(const BestRouteInput& input) {
+  if (!input.ship_performance_info.ShipDraft.has_value()) {
+    return std::nullopt;
+  }
+  const double draft = input.ship_performance_info.ShipDraft.value();
+  const auto shallow_mask = depth_mask_provider_->GetShallowMask(draft);
+  // Shoal polygons are traced only for drafts configured when a depth grid is loaded, so the draft may have
+  // no polygons in some grids. The time scorer checks every edge against the mask built from depth points.
+  const auto shoal_draft = db_client_->SelectShoalDraft(draft);
+  if (shallow_mask == nullptr || !shoal_draft.has_value()) {
+    return std::nullopt;
+  }
+
+  // obstacles are extended, so straight edges along them stay out of shallow mask cells
+  const double cell_size = shallow_mask->GetGeometry().cell_size;
+  const auto zone = MakeBoundsPolygon(input);
+  const auto obstacles = db_client_->SelectShoalPolygonsInZone(zone, shoal_draft.value(), 3 * cell_size, cell_size);
+
+  const auto& route_segments = input.route->GetSegments();
+  const auto graph = entities::VisibilityGraph::Build(
+      zone, obstacles, route_segments.front().segment.Start, route_segments.back().segment.End,
+      kMaxVisibilityVertexCount);
+  if (!graph.has_value()) {
+    wxLogInfo(_T("Too many obstacle vertices for visibility graph"));
+    return std::nullopt;
+  }
+
+  const auto scorer = MakeTimeScorer(graph->GetPoints(), input);
+  auto result = MakeBestRouteWithScorer(*graph, graph->GetStartPointId(), graph->GetEndPointId(), scorer);
+  if (!result.has_value()) {
+    return std::nullopt;
+  }
+  if (HasSignificantWeatherVariation(*db_client_, input, result->points)) {
+    wxLogInfo(_T("Weather varies along the route edges, visibility graph route is not used"));
+    return std::nullopt;
+  }
+
+  SetMaxTimeToSafety(result.value(), input);
+  return result;
+}
+
+std::optional<BestRouteResult> BestRouteMaker::MakeBestRouteOnQuadtree(const BestRouteInput& input) {
+  const auto zone = MakeBoundsPolygon(input);
+  std::shared_ptr<const entities::DangerDistanceField> distance_field;
+  if (input.ship_performance_info.ShipDraft.has_value()) {
+    distance_field = depth_mask_provider_->GetDangerDistanceField(input.ship_performance_info.ShipDraft.value());
+  }
+  const QuadtreeSplitCriteria split_criteria(zone, input, distance_field, *db_client_);
+
+  std::optional<entities::QuadtreeRouteGrid> grid;
+  try {
+    grid.emplace(zone, kStep, kQuadtreeMaxLevel, [&](common::Point center, double size) {
+      return split_criteria.NeedSplit(center, size);
+    });
+  } catch (const std::exception& ex) {
+    wxLogInfo(_T("Failed to build quadtree grid with reason: %s"), ex.what());
+    return std::nullopt;
+  }
+
+  const auto& route_segments = input.route->GetSegments();
+  const int start_point_id = grid->GetClosestPointId(route_segments.front().segment.Start);
+  const int end_point_id = grid->GetClosestPointId(route_segments.back().segment.End);
+  auto result = MakeBestRouteWithScorer(*grid, start_point_id, end_point_id, MakeTimeScorer(grid->GetPoints(), input));
+  if (!result.has_value()) {
+    return std::nullopt;
+  }
+  SetMaxTimeToSafety(result.value(), input);
+  return result;
+}
+
+std::shared_ptr<scorers::TimeScorer> BestRouteMaker::MakeTimeScorer(
+    const std::vector<common::Point>& points, const BestRouteInput& input) {
+  std::shared_ptr<const entities::ShallowMask> shallow_mask;
+  std::shared_ptr<const entities::DangerDistanceField> distance_field;
+  if (input.ship_performance_info.ShipDraft.has_value()) {
+    shallow_mask = depth_mask_provider_->GetShallowMask(input.ship_performance_info.ShipDraft.value());
+    distance_field = depth_mask_provider_->GetDangerDistanceField(input.ship_performance_info.ShipDraft.value());
+  }
+
+  return std::make_shared<scorers::TimeScorer>(
     input.ship_performance_info,
-    find_route_grid.GetPoints(),
+    points,
     db_client_,
-    input.depart_time
+    input.depart_time,
+    shallow_mask,
+    distance_field
   );
+}
+
+void BestRouteMaker::SetMaxTimeToSafety(BestRouteResult& result, const BestRouteInput& input) {
+  // the safety field is computed over the uniform zone grid, which is shared with other searches
+  try {
+    const auto zone = MakeBoundsPolygon(input);
+    const auto safety_field = safe_point_manager_->GetSafetyField(
+        find_route_grid_cache_->Get(zone, GetUniformStep(zone)), input.ship_performance_info, input.depart_time);
+    if (safety_field != nullptr) {
+      result.max_time_to_safety = GetMaxTimeToSafety(*safety_field, result.points);
+    }
+  } catch (const std::exception& ex) {
+    wxLogInfo(_T("Failed to get time to safety with reason: %s"), ex.what());
+  }
+}
+
+std::optional<BestRouteResult> BestRouteMaker::MakeBestRouteOnGrid(
+    std::shared_ptr<const entities::FindRouteGrid> find_route_grid,
+    const BestRouteInput& input) {
+  const auto& route_segments = input.route->GetSegments();
+
+  int start_point_id =
+      find_route_grid->GetClosestPointId(route_segments.front().segment.Start);
+  int end_point_id =
+      find_route_grid->GetClosestPointId(route_segments.back().segment.End);
+
+  std::shared_ptr<scorers::IScorer> scorer = MakeTimeScorer(find_route_grid->GetPoints(), input);
   /*
   switch (input.score_type) {
     case BestRouteInput::ScoreType::kTime:
@@ -109,7 +436,13 @@ BestRouteResult BestRouteMaker::MakeBestRoute(const BestRouteInput& input) {
     default:
       throw std::runtime_error("unknown score type");
   }*/
-  return MakeBestRouteWithScorer(find_route_grid, start_point_id, end_point_id, scorer);
+  auto result = MakeBestRouteWithScorer(*find_route_grid, start_point_id, end_point_id, scorer);
+  if (!result.has_value()) {
+    return std::nullopt;
+  }
+
+  SetMaxTimeToSafety(result.value(), input);
+  return result;
 }
 
 }  // namespace marine_navi::cases
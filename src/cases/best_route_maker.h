@@ -1,8 +1,14 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 
+#include "cases/depth_mask_provider.h"
+#include "cases/find_route_grid_cache.h"
+#include "cases/safe_point_manager.h"
+#include "cases/scorers/time_scorer.h"
 #include "clients/db_client.h"
+#include "entities/find_route_grid.h"
 #include "entities/route.h"
 #include "entities/ship.h"
 
@@ -13,6 +19,9 @@ struct BestRouteInput {
   std::shared_ptr<entities::Route> bounds;
   entities::ShipPerformanceInfo ship_performance_info;
   time_t depart_time;
+  // width in meters of the area around route where the best route is searched,
+  // the whole bounds zone is used if not set
+  std::optional<double> corridor_width;
 
   enum class ScoreType {
     kTime,
@@ -24,16 +33,37 @@ struct BestRouteResult {
   std::vector<common::Point> points;
 
   time_t arrival_time;
+
+  // the longest time to reach safe point from the route nodes, std::nullopt if refuge is unknown
+  std::optional<double> max_time_to_safety;
 };
 
 class BestRouteMaker{
 public:
-    BestRouteMaker(std::shared_ptr<clients::DbClient> db_client);
+    BestRouteMaker(std::shared_ptr<clients::DbClient> db_client,
+                   std::shared_ptr<SafePointManager> safe_point_manager,
+                   std::shared_ptr<FindRouteGridCache> find_route_grid_cache,
+                   std::shared_ptr<DepthMaskProvider> depth_mask_provider);
 
     BestRouteResult MakeBestRoute(const BestRouteInput& input);
 
+private:
+    // fast path for zones where shoals dominate and weather is uniform, std::nullopt if it does not apply
+    std::optional<BestRouteResult> MakeBestRouteOnVisibilityGraph(const BestRouteInput& input);
+    // search over the whole zone with cells refined near danger and weather changes
+    std::optional<BestRouteResult> MakeBestRouteOnQuadtree(const BestRouteInput& input);
+    std::optional<BestRouteResult> MakeBestRouteOnGrid(
+        std::shared_ptr<const entities::FindRouteGrid> find_route_grid,
+        const BestRouteInput& input);
+    std::shared_ptr<scorers::TimeScorer> MakeTimeScorer(const std::vector<common::Point>& points,
+                                                        const BestRouteInput& input);
+    void SetMaxTimeToSafety(BestRouteResult& result, const BestRouteInput& input);
+
 private:
     std::shared_ptr<clients::DbClient> db_client_;
+    std::shared_ptr<SafePointManager> safe_point_manager_;
+    std::shared_ptr<FindRouteGridCache> find_route_grid_cache_;
+    std::shared_ptr<DepthMaskProvider> depth_mask_provider_;
 
 };
 
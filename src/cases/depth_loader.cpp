@@ -1,5 +1,8 @@
 #include "depth_loader.h"
 
+#include <wx/log.h>
+
+#include <cases/helpers/shoal_tracer.h>
 #include <entities/depth_grid.h>
 
 namespace marine_navi::cases {
@@ -8,6 +11,15 @@ void DepthLoader::Load(const std::string& path) {
     const auto grid = entities::DepthGrid(path);
     const auto points = grid.GetAllPoints();
     db_client_->InsertDepthPointBatch(points);
+    db_client_->InsertDepthGrid(grid.GetGeometry());
+
+    for (const double draft : shoal_drafts_) {
+        const auto polygons = helpers::TraceShoalPolygons(grid, draft);
+        db_client_->InsertShoalPolygons(polygons);
+        wxLogInfo(_T("%zu shoal polygons for draft %lf"), polygons.size(), draft);
+    }
+    db_client_->ResetCachedVersions();
+    db_client_->DeleteScanResults();
 }
 
 } // namespace marine_navi::cases
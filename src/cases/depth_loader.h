@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <clients/db_client.h>
 
@@ -9,12 +10,15 @@ namespace marine_navi::cases {
 
 class DepthLoader {
 public:
-    DepthLoader(std::shared_ptr<clients::DbClient> db_client): db_client_(db_client) {}
+    // shoal polygons are traced for every draft of shoal_drafts
+    DepthLoader(std::shared_ptr<clients::DbClient> db_client, std::vector<double> shoal_drafts = {})
+        : db_client_(db_client), shoal_drafts_(std::move(shoal_drafts)) {}
     void Load(const std::string& path);
 
 private:
   std::shared_ptr<clients::DbClient> db_client_;
+  const std::vector<double> shoal_drafts_;
 
 };
 
-} // namespace marine_navi::cases
\ No newline at end of file
+} // namespace marine_navi::cases
@@ -0,0 +1,244 @@
+#include "depth_mask_provider.h"
+
+#include <filesystem>
+#include <fstream>
+
+#include <wx/log.h>
+
+#include "common/hash.h"
+
+namespace marine_navi::cases {
+
+namespace {
+namespace fs = std::filesystem;
+
+constexpr double kDraftBandMeters = 0.5;
+const std::string kShallowMaskPrefix = "shallow";
+const std::string kDistanceFieldPrefix = "distance";
+
+// Written before the value, a file is used only for the key it was saved with, so a collision of file
+// names never loads another value
+struct FileKey {
+  uint64_t version;
+  double draft_band;
+};
+
+template <typename T>
+std::shared_ptr<const T> LoadFromFile(const std::string& path, const FileKey& key) {
+  if (!fs::exists(path)) {
+    return nullptr;
+  }
+  try {
+    std::ifstream file(path, std::ios::binary);
+    FileKey file_key;
+    if (!file.read(reinterpret_cast<char*>(&file_key), sizeof(file_key))) {
+      throw std::runtime_error("unexpected end of file");
+    }
+    if (file_key.version != key.version || file_key.draft_band != key.draft_band) {
+      throw std::runtime_error("file is saved for another key");
+    }
+    return std::make_shared<const T>(T::Load(file));
+  } catch (const std::exception& ex) {
+    wxLogWarning(_T("Failed to load '%s' with reason: %s"), path, ex.what());
+    return nullptr;
+  }
+}
+
+template <typename T>
+void SaveToFile(const std::string& path, const FileKey& key, const T& value) {
+  std::error_code ec;
+  fs::create_directories(fs::path(path).parent_path(), ec);
+
+  const std::string tmp_path = path + ".tmp";
+  {
+    std::ofstream file(tmp_path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(&key), sizeof(key));
+    value.Save(file);
+    if (!file) {
+      wxLogWarning(_T("Failed to save '%s'"), tmp_path);
+      return;
+    }
+  }
+  fs::rename(tmp_path, path, ec);
+  if (ec) {
+    wxLogWarning(_T("Failed to save '%s' with reason: %s"), path, ec.message());
+  }
+}
+
+}  // namespace
+
+DepthMaskProvider::DepthMaskProvider(std::shared_ptr<clients::DbClient> db_client,
+                                     std::shared_ptr<common::ThreadPool> thread_pool,
+                                     std::optional<std::string> cache_dir)
+    : db_client_(db_client), thread_pool_(thread_pool), cache_dir_(cache_dir), version_(0) {}
+
+double DepthMaskProvider::GetDraftBand(double draft) {
+  return std::ceil(draft / kDraftBandMeters) * kDraftBandMeters;
+}
+
+std::shared_ptr<const entities::ShallowMask> DepthMaskProvider::GetShallowMask(double draft) {
+  std::lock_guard lock(mutex_);
+
+  const auto depth_version = UpdateDepthVersion();
+  if (!depth_version.has_value()) {
+    return nullptr;
+  }
+  return GetShallowMaskLocked(depth_version.value(), GetDraftBand(draft));
+}
+
+std::shared_ptr<const entities::DangerDistanceField> DepthMaskProvider::GetDangerDistanceField(double draft) {
+  std::lock_guard lock(mutex_);
+
+  const auto depth_version = UpdateDepthVersion();
+  if (!depth_version.has_value()) {
+    return nullptr;
+  }
+
+  const double draft_band = GetDraftBand(draft);
+  if (auto it = distance_fields_.find(draft_band); it != distance_fields_.end()) {
+    return it->second;
+  }
+
+  auto field = LoadCached<entities::DangerDistanceField>(kDistanceFieldPrefix, version_, draft_band);
+  if (field == nullptr) {
+    const auto mask = GetShallowMaskLocked(depth_version.value(), draft_band);
+    wxLogInfo(_T("Build distance to danger field for draft %lf"), draft_band);
+    field = std::make_shared<const entities::DangerDistanceField>(
+        entities::DangerDistanceField::Build(*mask, *thread_pool_));
+    SaveCached(kDistanceFieldPrefix, version_, *field);
+  }
+  distance_fields_[draft_band] = field;
+  return field;
+}
+
+std::optional<uint64_t> DepthMaskProvider::GetVersion() {
+  std::lock_guard lock(mutex_);
+
+  const auto depth_version = UpdateDepthVersion();
+  if (!depth_version.has_value()) {
+    return std::nullopt;
+  }
+  return depth_version->hash;
+}
+
+std::optional<DepthMaskProvider::DepthVersion> DepthMaskProvider::UpdateDepthVersion() {
+  auto depth_version = GetDepthVersion();
+  if (depth_version.has_value() && depth_version->hash != version_) {
+    version_ = depth_version->hash;
+    masks_.clear();
+    distance_fields_.clear();
+    RemoveStaleFiles();
+  }
+  return depth_version;
+}
+
+void DepthMaskProvider::RemoveStaleFiles() const {
+  if (!cache_dir_.has_value()) {
+    return;
+  }
+  // files of the current version are named prefix_version_band.bin
+  const std::string version_part = "_" + common::ToHexString(version_) + "_";
+  std::error_code ec;
+  for (const auto& entry : fs::directory_iterator(cache_dir_.value(), ec)) {
+    const auto name = entry.path().filename().string();
+    const bool is_cached = name.rfind(kShallowMaskPrefix + "_", 0) == 0 || name.rfind(kDistanceFieldPrefix + "_", 0) == 0;
+    if (is_cached && name.find(version_part) == std::string::npos) {
+      std::error_code remove_ec;
+      fs::remove(entry.path(), remove_ec);
+      if (remove_ec) {
+        wxLogWarning(_T("Failed to remove '%s' with reason: %s"), entry.path().string(), remove_ec.message());
+      }
+    }
+  }
+}
+
+std::shared_ptr<const entities::ShallowMask> DepthMaskProvider::GetShallowMaskLocked(
+    const DepthVersion& depth_version, double draft_band) {
+  if (auto it = masks_.find(draft_band); it != masks_.end()) {
+    return it->second;
+  }
+
+  auto mask = LoadCached<entities::ShallowMask>(kShallowMaskPrefix, version_, draft_band);
+  if (mask == nullptr) {
+    mask = std::make_shared<const entities::ShallowMask>(BuildMask(depth_version.geometry, draft_band));
+    SaveCached(kShallowMaskPrefix, version_, *mask);
+  }
+  masks_[draft_band] = mask;
+  return mask;
+}
+
+std::optional<DepthMaskProvider::DepthVersion> DepthMaskProvider::GetDepthVersion() {
+  const auto depth_grids = db_client_->SelectDepthGrids();
+  if (depth_grids.empty()) {
+    return std::nullopt;
+  }
+
+  // the raster covers all loaded grids with the coarsest cell, so every depth point marks a whole cell
+  common::Hasher hasher;
+  double min_lat = depth_grids[0].geometry.min_lat;
+  double min_lon = depth_grids[0].geometry.min_lon;
+  double max_lat = depth_grids[0].geometry.GetMaxLat();
+  double max_lon = depth_grids[0].geometry.GetMaxLon();
+  double cell_size = depth_grids[0].geometry.cell_size;
+  for (const auto& depth_grid : depth_grids) {
+    const auto& geometry = depth_grid.geometry;
+    hasher.Add(depth_grid.id).Add(geometry.min_lat).Add(geometry.min_lon).Add(geometry.cell_size);
+    min_lat = std::min(min_lat, geometry.min_lat);
+    min_lon = std::min(min_lon, geometry.min_lon);
+    max_lat = std::max(max_lat, geometry.GetMaxLat());
+    max_lon = std::max(max_lon, geometry.GetMaxLon());
+    cell_size = std::max(cell_size, geometry.cell_size);
+  }
+
+  return DepthVersion{
+    .hash = hasher.Get(),
+    .geometry = entities::RasterGeometry{
+      .min_lat = min_lat,
+      .min_lon = min_lon,
+      .cell_size = cell_size,
+      .n_rows = static_cast<uint32_t>(std::ceil((max_lat - min_lat) / cell_size)),
+      .n_cols = static_cast<uint32_t>(std::ceil((max_lon - min_lon) / cell_size)),
+    },
+  };
+}
+
+std::optional<std::string> DepthMaskProvider::GetFilePath(
+    const std::string& prefix, uint64_t version, double draft_band) const {
+  if (!cache_dir_.has_value()) {
+    return std::nullopt;
+  }
+  const auto name = prefix + "_" + common::ToHexString(version) + "_" +
+                    std::to_string(static_cast<int64_t>(std::llround(draft_band * 100))) + ".bin";
+  return (fs::path(cache_dir_.value()) / name).string();
+}
+
+template <typename T>
+std::shared_ptr<const T> DepthMaskProvider::LoadCached(
+    const std::string& prefix, uint64_t version, double draft_band) const {
+  const auto path = GetFilePath(prefix, version, draft_band);
+  if (!path.has_value()) {
+    return nullptr;
+  }
+  return LoadFromFile<T>(path.value(), FileKey{version, draft_band});
+}
+
+template <typename T>
+void DepthMaskProvider::SaveCached(const std::string& prefix, uint64_t version, const T& value) const {
+  if (const auto path = GetFilePath(prefix, version, value.GetDraft()); path.has_value()) {
+    SaveToFile(path.value(), FileKey{version, value.GetDraft()}, value);
+  }
+}
+
+entities::ShallowMask DepthMaskProvider::BuildMask(const entities::RasterGeometry& geometry,
+                                                   double draft_band) {
+  wxLogInfo(_T("Build shallow mask for draft %lf"), draft_band);
+  entities::ShallowMask mask(geometry, draft_band);
+  for (const auto& point : db_client_->SelectShallowDepthPoints(draft_band)) {
+    if (const auto cell = geometry.GetCell(point); cell.has_value()) {
+      mask.SetShallow(cell->first, cell->second);
+    }
+  }
+  return mask;
+}
+
+}  // namespace marine_navi::cases
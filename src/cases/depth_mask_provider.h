@@ -0,0 +1,65 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "clients/db_client.h"
+#include "common/thread_pool.h"
+#include "entities/danger_distance_field.h"
+#include "entities/shallow_mask.h"
+
+namespace marine_navi::cases {
+
+// Builds shallow water masks and distance to danger fields from loaded depths once per draft band
+// and keeps them in memory and in cache directory until new depths are loaded. Files of previous
+// depths are removed, every file is checked against the depth version and draft band it was saved for.
+class DepthMaskProvider {
+public:
+  DepthMaskProvider(std::shared_ptr<clients::DbClient> db_client,
+                    std::shared_ptr<common::ThreadPool> thread_pool,
+                    std::optional<std::string> cache_dir = std::nullopt);
+
+  // @return mask for the draft rounded up to draft band, nullptr if there is no depth grid
+  std::shared_ptr<const entities::ShallowMask> GetShallowMask(double draft);
+  // @return distance field for the draft rounded up to draft band, nullptr if there is no depth grid
+  std::shared_ptr<const entities::DangerDistanceField> GetDangerDistanceField(double draft);
+
+  // @return hash of the loaded depth grids, it changes when new depths are loaded
+  std::optional<uint64_t> GetVersion();
+
+  static double GetDraftBand(double draft);
+
+private:
+  struct DepthVersion {
+    uint64_t hash;
+    entities::RasterGeometry geometry;
+  };
+
+  std::optional<DepthVersion> UpdateDepthVersion();
+  // removes cached files of other depth versions, so the cache directory keeps only the current one
+  void RemoveStaleFiles() const;
+  std::shared_ptr<const entities::ShallowMask> GetShallowMaskLocked(
+      const DepthVersion& depth_version, double draft_band);
+  std::optional<DepthVersion> GetDepthVersion();
+  std::optional<std::string> GetFilePath(const std::string& prefix, uint64_t version, double draft_band) const;
+  template <typename T>
+  std::shared_ptr<const T> LoadCached(const std::string& prefix, uint64_t version, double draft_band) const;
+  template <typename T>
+  void SaveCached(const std::string& prefix, uint64_t version, const T& value) const;
+  entities::ShallowMask BuildMask(const entities::RasterGeometry& geometry, double draft_band);
+
+private:
+  std::shared_ptr<clients::DbClient> db_client_;
+  std::shared_ptr<common::ThreadPool> thread_pool_;
+  const std::optional<std::string> cache_dir_;
+
+  std::mutex mutex_;
+  uint64_t version_;
+  std::map<double, std::shared_ptr<const entities::ShallowMask>> masks_;
+  std::map<double, std::shared_ptr<const entities::DangerDistanceField>> distance_fields_;
+};
+
+}  // namespace marine_navi::cases
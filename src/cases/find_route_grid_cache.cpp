@@ -0,0 +1,162 @@
+#include "find_route_grid_cache.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include <wx/log.h>
+
+#include "common/hash.h"
+
+namespace marine_navi::cases {
+
+namespace {
+namespace fs = std::filesystem;
+
+// grid files kept in cache directory, corridor grids are keyed by route geometry and pile up as routes are edited
+const size_t kMaxCachedFiles = 100;
+const std::string kFilePrefix = "grid_";
+}  // namespace
+
+FindRouteGridCache::FindRouteGridCache(size_t memory_budget, std::optional<std::string> cache_dir)
+    : memory_budget_(memory_budget), cache_dir_(cache_dir), memory_usage_(0) {}
+
+std::shared_ptr<const entities::FindRouteGrid> FindRouteGridCache::Get(
+    const common::Polygon& polygon, double step) {
+  return GetOrBuild(entities::FindRouteGrid::MakeKey(polygon, step), [&] {
+    return entities::FindRouteGrid(polygon, step);
+  });
+}
+
+std::shared_ptr<const entities::FindRouteGrid> FindRouteGridCache::Get(
+    const common::Polygon& polygon, const std::vector<common::Segment>& corridor,
+    double buffer, double step) {
+  return GetOrBuild(entities::FindRouteGrid::MakeKey(polygon, corridor, buffer, step), [&] {
+    return entities::FindRouteGrid(polygon, corridor, buffer, step);
+  });
+}
+
+FindRouteGridCache::GridPtr FindRouteGridCache::GetOrBuild(
+    uint64_t key, const std::function<entities::FindRouteGrid()>& build) {
+  if (auto grid = FindInMemory(key); grid != nullptr) {
+    return grid;
+  }
+
+  // grid is built without lock, concurrent searches of the same zone may build it twice
+  auto grid = LoadFromDisk(key);
+  if (grid == nullptr) {
+    grid = std::make_shared<const entities::FindRouteGrid>(build());
+    SaveToDisk(key, *grid);
+  }
+  Insert(key, grid);
+  return grid;
+}
+
+FindRouteGridCache::GridPtr FindRouteGridCache::FindInMemory(uint64_t key) {
+  std::lock_guard lock(mutex_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    return nullptr;
+  }
+  order_.splice(order_.begin(), order_, it->second.order_it);
+  return it->second.grid;
+}
+
+void FindRouteGridCache::Insert(uint64_t key, GridPtr grid) {
+  std::lock_guard lock(mutex_);
+  if (entries_.count(key) > 0) {
+    return;
+  }
+  const size_t memory_usage = grid->GetMemoryUsage();
+  order_.push_front(key);
+  entries_.emplace(key, Entry{grid, memory_usage, order_.begin()});
+  memory_usage_ += memory_usage;
+
+  // the newest grid is kept even if it alone exceeds the budget
+  while (memory_usage_ > memory_budget_ && order_.size() > 1) {
+    auto it = entries_.find(order_.back());
+    memory_usage_ -= it->second.memory_usage;
+    entries_.erase(it);
+    order_.pop_back();
+  }
+}
+
+std::optional<std::string> FindRouteGridCache::GetFilePath(uint64_t key) const {
+  if (!cache_dir_.has_value()) {
+    return std::nullopt;
+  }
+  return (fs::path(cache_dir_.value()) / (kFilePrefix + common::ToHexString(key) + ".bin")).string();
+}
+
+FindRouteGridCache::GridPtr FindRouteGridCache::LoadFromDisk(uint64_t key) const {
+  const auto path = GetFilePath(key);
+  if (!path.has_value() || !fs::exists(path.value())) {
+    return nullptr;
+  }
+  try {
+    std::ifstream file(path.value(), std::ios::binary);
+    auto grid = std::make_shared<const entities::FindRouteGrid>(entities::FindRouteGrid::Load(file));
+    // the modification time orders files for eviction, so used grids are kept
+    std::error_code ec;
+    fs::last_write_time(path.value(), fs::file_time_type::clock::now(), ec);
+    return grid;
+  } catch (const std::exception& ex) {
+    wxLogWarning(_T("Failed to load grid from '%s' with reason: %s"), path.value(), ex.what());
+    return nullptr;
+  }
+}
+
+void FindRouteGridCache::SaveToDisk(uint64_t key, const entities::FindRouteGrid& grid) const {
+  const auto path = GetFilePath(key);
+  if (!path.has_value()) {
+    return;
+  }
+  std::error_code ec;
+  fs::create_directories(cache_dir_.value(), ec);
+
+  // write to temporary file first so a reader never sees half written grid
+  const std::string tmp_path = path.value() + ".tmp";
+  {
+    std::ofstream file(tmp_path, std::ios::binary);
+    grid.Save(file);
+    if (!file) {
+      wxLogWarning(_T("Failed to save grid to '%s'"), tmp_path);
+      return;
+    }
+  }
+  fs::rename(tmp_path, path.value(), ec);
+  if (ec) {
+    wxLogWarning(_T("Failed to save grid to '%s' with reason: %s"), path.value(), ec.message());
+  }
+  RemoveOldFiles();
+}
+
+void FindRouteGridCache::RemoveOldFiles() const {
+  std::vector<std::pair<fs::file_time_type, fs::path>> files;
+  std::error_code ec;
+  for (const auto& entry : fs::directory_iterator(cache_dir_.value(), ec)) {
+    const auto name = entry.path().filename().string();
+    if (name.rfind(kFilePrefix, 0) == 0 && entry.path().extension() == ".bin") {
+      std::error_code time_ec;
+      const auto time = fs::last_write_time(entry.path(), time_ec);
+      if (!time_ec) {
+        files.emplace_back(time, entry.path());
+      }
+    }
+  }
+  if (files.size() <= kMaxCachedFiles) {
+    return;
+  }
+
+  std::sort(files.begin(), files.end());
+  for (size_t i = 0; i + kMaxCachedFiles < files.size(); ++i) {
+    std::error_code remove_ec;
+    fs::remove(files[i].second, remove_ec);
+    if (remove_ec) {
+      wxLogWarning(_T("Failed to remove '%s' with reason: %s"), files[i].second.string(), remove_ec.message());
+    }
+  }
+}
+
+}  // namespace marine_navi::cases
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "entities/find_route_grid.h"
+
+namespace marine_navi::cases {
+
+// LRU cache of built grids limited by memory, grids are shared between searches and never modified.
+// Grids evicted from memory stay in cache directory and are reused across sessions, the least recently
+// used files are removed when there are too many of them.
+class FindRouteGridCache {
+public:
+  FindRouteGridCache(size_t memory_budget, std::optional<std::string> cache_dir = std::nullopt);
+
+  std::shared_ptr<const entities::FindRouteGrid> Get(const common::Polygon& polygon, double step);
+  std::shared_ptr<const entities::FindRouteGrid> Get(const common::Polygon& polygon,
+                                                     const std::vector<common::Segment>& corridor,
+                                                     double buffer, double step);
+
+private:
+  using GridPtr = std::shared_ptr<const entities::FindRouteGrid>;
+
+  struct Entry {
+    GridPtr grid;
+    size_t memory_usage;
+    std::list<uint64_t>::iterator order_it;
+  };
+
+  GridPtr GetOrBuild(uint64_t key, const std::function<entities::FindRouteGrid()>& build);
+  GridPtr FindInMemory(uint64_t key);
+  void Insert(uint64_t key, GridPtr grid);
+
+  std::optional<std::string> GetFilePath(uint64_t key) const;
+  GridPtr LoadFromDisk(uint64_t key) const;
+  void SaveToDisk(uint64_t key, const entities::FindRouteGrid& grid) const;
+  void RemoveOldFiles() const;
+
+private:
+  const size_t memory_budget_;
+  const std::optional<std::string> cache_dir_;
+
+  std::mutex mutex_;
+  std::list<uint64_t> order_;  // most recently used first
+  std::unordered_map<uint64_t, Entry> entries_;
+  size_t memory_usage_;
+};
+
+}  // namespace marine_navi::cases
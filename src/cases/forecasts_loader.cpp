@@ -34,6 +34,8 @@ void ForecastsLoader::Load() {
     try {
       int64_t forecastId = db_client_->InsertForecast(forecast.Source);
       db_client_->InsertForecastRecordBatch(records, forecastId);
+      db_client_->ResetCachedVersions();
+      db_client_->DeleteScanResults();
     } catch (SQLite::Exception& ex) {
       wxLogError(_T("Failed to load forecasts with reason: %s"), ex.what());
       throw ex;
@@ -0,0 +1,76 @@
+#include "corridor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace marine_navi::cases::helpers {
+
+namespace {
+
+// the distance the ship goes before a position fix shows its steering error
+constexpr double kCorridorLookAheadMeters = 30000;
+constexpr double kMinCorridorHalfWidthMeters = 200;
+constexpr double kMaxCorridorHalfWidthMeters = 2000;
+
+// Equirectangular projection at the segment latitude, in meters. It is linear, so polygons built
+// from projected points have the same inner points as in coordinates
+class LocalProjection {
+public:
+  explicit LocalProjection(const common::Segment& segment)
+    : origin_(segment.Start),
+      lon_scale_(common::kMetersPerDegree * std::cos((segment.Start.Lat + segment.End.Lat) / 2 * M_PI / 180)) {}
+
+  // @return x to the east and y to the north in meters
+  std::pair<double, double> ToMeters(const common::Point& point) const {
+    return {(point.Lon - origin_.Lon) * lon_scale_, (point.Lat - origin_.Lat) * common::kMetersPerDegree};
+  }
+  common::Point ToPoint(double x, double y) const {
+    return common::Point{origin_.Lat + y / common::kMetersPerDegree, origin_.Lon + x / lon_scale_};
+  }
+
+private:
+  common::Point origin_;
+  double lon_scale_;
+};
+
+}  // namespace
+
+double GetCorridorHalfWidth(double alpha) {
+  return std::clamp(kCorridorLookAheadMeters * std::tan(std::min(alpha, M_PI / 4)),
+                    kMinCorridorHalfWidthMeters, kMaxCorridorHalfWidthMeters);
+}
+
+std::vector<CorridorTile> MakeCorridorTiles(const common::Segment& segment, double half_width, double tile_length) {
+  const LocalProjection projection(segment);
+  const auto [end_x, end_y] = projection.ToMeters(segment.End);
+  const double length = std::hypot(end_x, end_y);
+  // a zero length segment gets a square around its start
+  const double dir_x = length > 0 ? end_x / length : 1;
+  const double dir_y = length > 0 ? end_y / length : 0;
+  const double normal_x = -dir_y * half_width;
+  const double normal_y = dir_x * half_width;
+
+  const size_t tile_count = std::max<size_t>(1, static_cast<size_t>(std::ceil(length / tile_length)));
+  std::vector<CorridorTile> result;
+  result.reserve(tile_count);
+  for (size_t i = 0; i < tile_count; ++i) {
+    // the first and the last tile reach half_width behind the segment ends
+    const double from = i == 0 ? -half_width : length * i / tile_count;
+    const double to = i + 1 == tile_count ? length + half_width : length * (i + 1) / tile_count;
+    const double from_x = dir_x * from;
+    const double from_y = dir_y * from;
+    const double to_x = dir_x * to;
+    const double to_y = dir_y * to;
+    result.push_back(CorridorTile{
+      .polygon = common::Polygon{{
+        projection.ToPoint(from_x - normal_x, from_y - normal_y),
+        projection.ToPoint(to_x - normal_x, to_y - normal_y),
+        projection.ToPoint(to_x + normal_x, to_y + normal_y),
+        projection.ToPoint(from_x + normal_x, from_y + normal_y),
+      }},
+    });
+  }
+  return result;
+}
+
+}  // namespace marine_navi::cases::helpers
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <vector>
+
+#include "common/geom.h"
+
+namespace marine_navi::cases::helpers {
+
+// Rectangle of the checked corridor around a part of a route segment
+struct CorridorTile {
+  common::Polygon polygon;
+};
+
+// @return half width in meters of the corridor a ship steering within alpha radians keeps to
+double GetCorridorHalfWidth(double alpha);
+
+// @return tiles at most tile_length meters long covering the corridor of half_width meters around the
+// segment, distances are measured in the local equirectangular projection of the segment
+std::vector<CorridorTile> MakeCorridorTiles(const common::Segment& segment, double half_width, double tile_length);
+
+}  // namespace marine_navi::cases::helpers
@@ -1,6 +1,8 @@
 #include "forecast_accessor.h"
 
 #include <algorithm>
+#include <cstdlib>
+#include <numeric>
 
 namespace marine_navi::cases::helpers {
 
@@ -8,44 +10,108 @@ namespace {
 
 const time_t kTooLate = 6*60*60;
 
-std::unordered_map<int, std::vector<std::tuple<entities::ForecastPoint, double, int>>> GroupForecasts(
-    std::vector<std::tuple<entities::ForecastPoint, double, int>> forecasts
+} // namespace
+
+ForecastAccessor::ForecastAccessor(
+    const std::vector<std::tuple<entities::ForecastPoint, double, int>>& forecasts
 ) {
-  std::unordered_map<int, std::vector<std::tuple<entities::ForecastPoint, double, int>>> result;
+  int max_point_id = -1;
   for (const auto& forecast : forecasts) {
-    result[std::get<2>(forecast)].push_back(forecast);
+    max_point_id = std::max(max_point_id, std::get<2>(forecast));
   }
 
-  return result;
-}
-
-} // namespace
+  // counting sort by point id keeps the query order of forecasts of a point
+  offsets_.assign(static_cast<size_t>(max_point_id + 1) + 1, 0);
+  for (const auto& forecast : forecasts) {
+    if (std::get<2>(forecast) >= 0) {
+      ++offsets_[std::get<2>(forecast) + 1];
+    }
+  }
+  std::partial_sum(offsets_.begin(), offsets_.end(), offsets_.begin());
 
-ForecastAccessor::ForecastAccessor(
-    std::vector<std::tuple<entities::ForecastPoint, double, int>> forecasts
-): forecasts_(GroupForecasts(forecasts)) {}
+  std::vector<size_t> order(offsets_.back());
+  auto next = offsets_;
+  for (size_t i = 0; i < forecasts.size(); ++i) {
+    if (std::get<2>(forecasts[i]) >= 0) {
+      order[next[std::get<2>(forecasts[i])]++] = i;
+    }
+  }
+  for (size_t id = 0; id + 1 < offsets_.size(); ++id) {
+    std::stable_sort(order.begin() + offsets_[id], order.begin() + offsets_[id + 1], [&](size_t lhs, size_t rhs) {
+      return std::get<0>(forecasts[lhs]).end_at < std::get<0>(forecasts[rhs]).end_at;
+    });
+  }
 
-std::optional<entities::ForecastPoint> ForecastAccessor::GetClosestForecast(int point_id, time_t expected_time) const {
-  auto it = forecasts_.find(point_id);
-  if (it == forecasts_.end()) {
-    return std::nullopt;
+  forecasts_.reserve(order.size());
+  end_times_.reserve(order.size());
+  for (const size_t i : order) {
+    forecasts_.push_back(std::get<0>(forecasts[i]));
+    end_times_.push_back(std::get<0>(forecasts[i]).end_at);
   }
+}
 
-  const auto& forecasts = it->second;
-  auto nearest_forecast = std::min_element(forecasts.begin(), forecasts.end(), [&expected_time](const auto& lhs, const auto& rhs) {
-    return std::abs(std::get<0>(lhs).end_at - expected_time) < std::abs(std::get<0>(rhs).end_at - expected_time);
-  });
+std::optional<entities::ForecastPoint> ForecastAccessor::PickClosest(
+    size_t before, size_t after, size_t end, time_t expected_time) const {
+  // before is the first forecast of the latest end time earlier than expected, after is the first one not earlier
+  std::optional<size_t> nearest;
+  if (before != after) {
+    nearest = before;
+  }
+  if (after != end && (!nearest.has_value() ||
+      end_times_[after] - expected_time < expected_time - end_times_[nearest.value()])) {
+    nearest = after;
+  }
 
-  if (nearest_forecast == forecasts.end()) {
+  if (!nearest.has_value() || std::abs(end_times_[nearest.value()] - expected_time) > kTooLate) {
     return std::nullopt;
   }
+  return forecasts_[nearest.value()];
+}
 
-  if (std::get<0>(*nearest_forecast).end_at - expected_time > kTooLate) {
+std::optional<entities::ForecastPoint> ForecastAccessor::GetClosestForecast(int point_id, time_t expected_time) const {
+  if (point_id < 0 || static_cast<size_t>(point_id) + 1 >= offsets_.size()) {
     return std::nullopt;
   }
 
-  return std::get<0>(*nearest_forecast);
+  const auto begin = end_times_.begin() + offsets_[point_id];
+  const auto end = end_times_.begin() + offsets_[point_id + 1];
+  const auto after = std::lower_bound(begin, end, expected_time);
+  const auto before = after == begin ? after : std::lower_bound(begin, after, *std::prev(after));
+  return PickClosest(before - end_times_.begin(), after - end_times_.begin(), end - end_times_.begin(),
+                     expected_time);
 }
 
+std::vector<std::optional<entities::ForecastPoint>> ForecastAccessor::GetClosestForecasts(
+    const std::vector<std::pair<int, time_t>>& queries) const {
+  std::vector<size_t> order(queries.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) { return queries[lhs] < queries[rhs]; });
+
+  // forecasts of a point are passed once for all its queries, which go by increasing time
+  std::vector<std::optional<entities::ForecastPoint>> result(queries.size());
+  for (size_t i = 0; i < order.size();) {
+    const int point_id = queries[order[i]].first;
+    if (point_id < 0 || static_cast<size_t>(point_id) + 1 >= offsets_.size()) {
+      for (; i < order.size() && queries[order[i]].first == point_id; ++i) {
+      }
+      continue;
+    }
+
+    const size_t begin = offsets_[point_id];
+    const size_t end = offsets_[point_id + 1];
+    size_t before = begin;
+    size_t after = begin;
+    for (; i < order.size() && queries[order[i]].first == point_id; ++i) {
+      const time_t expected_time = queries[order[i]].second;
+      for (; after != end && end_times_[after] < expected_time; ++after) {
+        if (end_times_[after] != end_times_[before]) {
+          before = after;
+        }
+      }
+      result[order[i]] = PickClosest(before, after, end, expected_time);
+    }
+  }
+  return result;
+}
 
-}  // namespace marine_navi::helpers
\ No newline at end of file
+}  // namespace marine_navi::helpers
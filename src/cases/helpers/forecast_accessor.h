@@ -1,24 +1,40 @@
 #pragma once
 
 #include <memory>
-#include <unordered_map>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 #include "entities/forecast_point.h"
 
 namespace marine_navi::cases::helpers {
 
-
+// Forecasts of points in one flat array, grouped by point id and sorted by end time within a point
 class ForecastAccessor {
 public:
-    ForecastAccessor(
-        std::vector<std::tuple<entities::ForecastPoint, double, int>> forecasts
+    // forecasts with distances to points and point ids, point ids are small non-negative indices
+    explicit ForecastAccessor(
+        const std::vector<std::tuple<entities::ForecastPoint, double, int>>& forecasts
     );
 
+    // binary search over forecasts of the point, @return the forecast ending closest to the time, the earlier one
+    // on a tie, nullopt if there are none or the closest one ends too late or too early
     std::optional<entities::ForecastPoint> GetClosestForecast(int point_id, time_t expected_time) const;
+    // answers (point id, time) queries in one pass over forecasts of each point
+    // @return closest forecasts in the order of queries
+    std::vector<std::optional<entities::ForecastPoint>> GetClosestForecasts(
+        const std::vector<std::pair<int, time_t>>& queries) const;
+
+private:
+    std::optional<entities::ForecastPoint> PickClosest(size_t before, size_t after, size_t end,
+                                                       time_t expected_time) const;
 
 private:
-    const std::unordered_map<int, std::vector<std::tuple<entities::ForecastPoint, double, int>>> forecasts_;
+    std::vector<size_t> offsets_;  // forecasts of point id are in [offsets_[id], offsets_[id + 1])
+    std::vector<time_t> end_times_;  // end times of forecasts_, kept apart for the search
+    std::vector<entities::ForecastPoint> forecasts_;
 };
 
 
-}  // namespace marine_navi::cases::helpers
\ No newline at end of file
+}  // namespace marine_navi::cases::helpers
@@ -0,0 +1,66 @@
+#include "hazard_clustering.h"
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+#include <unordered_map>
+
+namespace marine_navi::cases::helpers {
+
+namespace {
+
+// @return key of the grid cell, columns of a row are narrowed by the latitude of the row center
+uint64_t GetCellKey(const common::Point& point, double cell_size) {
+  const double lat_step = cell_size / common::kMetersPerDegree;
+  const auto row = static_cast<int64_t>(std::floor(point.Lat / lat_step));
+  const double row_lat = (row + 0.5) * lat_step;
+  const double lon_step = lat_step / std::max(std::cos(row_lat * M_PI / 180), 1e-6);
+  const auto col = static_cast<int64_t>(std::floor(point.Lon / lon_step));
+  return (static_cast<uint64_t>(row) << 32) ^ static_cast<uint32_t>(col);
+}
+
+bool IsLess(const common::Point& lhs, const common::Point& rhs) {
+  return std::tie(lhs.Lat, lhs.Lon) < std::tie(rhs.Lat, rhs.Lon);
+}
+
+}  // namespace
+
+std::pmr::vector<HazardCluster> ClusterHazards(const HazardSamples& hazards, double cell_size) {
+  auto* memory = hazards.get_allocator().resource();
+  std::pmr::vector<HazardCluster> result(memory);
+  std::pmr::unordered_map<uint64_t, size_t> cell_clusters(memory);
+  cell_clusters.reserve(hazards.size());
+  for (const auto& hazard : hazards) {
+    const auto [it, inserted] = cell_clusters.try_emplace(GetCellKey(hazard.location, cell_size), result.size());
+    if (inserted) {
+      result.push_back(HazardCluster{
+        .location = hazard.location,
+        .count = 1,
+        .worst_value = hazard.value,
+        .earliest_time = hazard.expected_time,
+        .latest_time = hazard.expected_time,
+      });
+      continue;
+    }
+    auto& cluster = result[it->second];
+    ++cluster.count;
+    cluster.earliest_time = std::min(cluster.earliest_time, hazard.expected_time);
+    cluster.latest_time = std::max(cluster.latest_time, hazard.expected_time);
+    // ties are broken by location, so the result does not depend on the order
+    if (hazard.value > cluster.worst_value ||
+        (hazard.value == cluster.worst_value && IsLess(hazard.location, cluster.location))) {
+      cluster.worst_value = hazard.value;
+      cluster.location = hazard.location;
+    }
+  }
+
+  std::sort(result.begin(), result.end(), [](const HazardCluster& lhs, const HazardCluster& rhs) {
+    if (lhs.earliest_time != rhs.earliest_time) {
+      return lhs.earliest_time < rhs.earliest_time;
+    }
+    return IsLess(lhs.location, rhs.location);
+  });
+  return result;
+}
+
+}  // namespace marine_navi::cases::helpers
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <ctime>
+#include <memory_resource>
+#include <vector>
+
+#include "common/geom.h"
+
+namespace marine_navi::cases::helpers {
+
+// Hazard found by a depth or wave check, the highest value is the worst one
+// (depths are negative below the sea level)
+struct HazardSample {
+  common::Point location;
+  time_t expected_time;
+  double value;
+};
+
+using HazardSamples = std::pmr::vector<HazardSample>;
+
+struct HazardCluster {
+  // location of the worst hazard
+  common::Point location;
+  size_t count;
+  double worst_value;
+  time_t earliest_time;
+  time_t latest_time;
+};
+
+// Merges hazards falling into the same cell of a grid with cells of cell_size meters, linear time.
+// Unlike merging neighbours in a sequence, the result does not depend on the order of hazards.
+// @return clusters by increasing earliest time, allocated from the memory of hazards
+std::pmr::vector<HazardCluster> ClusterHazards(const HazardSamples& hazards, double cell_size);
+
+}  // namespace marine_navi::cases::helpers
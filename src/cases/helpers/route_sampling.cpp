@@ -0,0 +1,66 @@
+#include "route_sampling.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace marine_navi::cases::helpers {
+
+namespace {
+
+// differences of coordinates below this are rounding noise
+constexpr double kCoordinateEpsilon = 1e-9;
+
+}  // namespace
+
+std::optional<double> GetGridStep(const std::vector<double>& sorted_coordinates) {
+  std::vector<double> steps;
+  for (size_t i = 1; i < sorted_coordinates.size(); ++i) {
+    const double step = sorted_coordinates[i] - sorted_coordinates[i - 1];
+    if (step > kCoordinateEpsilon) {
+      steps.push_back(step);
+    }
+  }
+  if (steps.empty()) {
+    return std::nullopt;
+  }
+  const auto median = steps.begin() + steps.size() / 2;
+  std::nth_element(steps.begin(), median, steps.end());
+  return *median;
+}
+
+std::vector<double> SampleSegment(const entities::RouteSegment& segment,
+                                  const entities::DangerDistanceField* field,
+                                  const SampleStepLimits& limits) {
+  const auto direction = segment.segment.End - segment.segment.Start;
+  std::vector<double> result;
+  double offset = 0;
+  do {
+    result.push_back(offset);
+    double step = limits.max_step;
+    if (field != nullptr && segment.length > 0) {
+      const auto distance = field->GetDistance(segment.segment.Start + direction * (offset / segment.length));
+      if (distance.has_value()) {
+        step = std::clamp(distance.value(), limits.min_step, limits.max_step);
+      }
+    }
+    offset += step;
+  } while (offset < segment.length);
+  return result;
+}
+
+std::vector<double> FindRefinedOffsets(const std::vector<double>& offsets,
+                                       const std::vector<std::optional<double>>& values,
+                                       double max_change, double min_step) {
+  std::vector<double> result;
+  for (size_t i = 1; i < offsets.size(); ++i) {
+    if (!values[i - 1].has_value() || !values[i].has_value() || offsets[i] - offsets[i - 1] < 2 * min_step) {
+      continue;
+    }
+    if (std::abs(values[i].value() - values[i - 1].value()) > max_change) {
+      result.push_back((offsets[i - 1] + offsets[i]) / 2);
+    }
+  }
+  return result;
+}
+
+}  // namespace marine_navi::cases::helpers
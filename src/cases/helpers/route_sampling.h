@@ -0,0 +1,34 @@
+#pragma once
+
+#include <optional>
+#include <vector>
+
+#include "entities/danger_distance_field.h"
+#include "entities/route.h"
+
+namespace marine_navi::cases::helpers {
+
+// Bounds of the sample step along a route segment in meters
+struct SampleStepLimits {
+  double min_step;
+  // the step in open water
+  double max_step;
+};
+
+// @return median of the positive differences of the sorted coordinates, the grid step in degrees.
+// std::nullopt if all coordinates are equal
+std::optional<double> GetGridStep(const std::vector<double>& sorted_coordinates);
+
+// @return offsets in meters from the segment start, the first one is 0. The step is the distance to the
+// closest danger clamped to the limits, so samples get denser near shallows. Without the field the max step is used
+std::vector<double> SampleSegment(const entities::RouteSegment& segment,
+                                  const entities::DangerDistanceField* field,
+                                  const SampleStepLimits& limits);
+
+// @return offsets of midpoints between neighbouring samples whose values differ more than max_change,
+// gaps shorter than 2 * min_step are not split
+std::vector<double> FindRefinedOffsets(const std::vector<double>& offsets,
+                                       const std::vector<std::optional<double>>& values,
+                                       double max_change, double min_step);
+
+}  // namespace marine_navi::cases::helpers
@@ -0,0 +1,73 @@
+#include "safety_field.h"
+
+#include <limits>
+#include <queue>
+
+namespace marine_navi::cases::helpers {
+
+namespace {
+
+constexpr double kUnreachable = std::numeric_limits<double>::infinity();
+
+}  // namespace
+
+SafetyField::SafetyField(std::shared_ptr<const entities::FindRouteGrid> grid,
+                         std::vector<double> time_to_safety)
+    : grid_(grid), time_to_safety_(std::move(time_to_safety)) {}
+
+std::optional<double> SafetyField::GetTimeToSafety(common::Point point) const {
+  const auto point_id = grid_->GetPointId(point);
+  if (!point_id.has_value()) {
+    return std::nullopt;
+  }
+  return GetTimeToSafety(point_id.value());
+}
+
+std::optional<double> SafetyField::GetTimeToSafety(int point_id) const {
+  const double time = time_to_safety_.at(point_id);
+  if (time == kUnreachable) {
+    return std::nullopt;
+  }
+  return time;
+}
+
+SafetyField BuildSafetyField(std::shared_ptr<const entities::FindRouteGrid> grid,
+                             const std::vector<entities::SafePoint>& safe_points,
+                             const std::function<double(int)>& speed_at) {
+  const auto& points = grid->GetPoints();
+  std::vector<double> time_to_safety(points.size(), kUnreachable);
+
+  using ValueType = std::pair<double, int>;  // time, point_id
+  std::priority_queue<ValueType, std::vector<ValueType>, std::greater<ValueType> > order;
+
+  for (const auto& safe_point : safe_points) {
+    // the closest point is searched over the whole grid, so only for safe points outside the grid cells
+    const auto cell_point_id = grid->GetPointId(safe_point.Point);
+    const int point_id = cell_point_id.has_value() ? cell_point_id.value() : grid->GetClosestPointId(safe_point.Point);
+    const double time = common::GetHaversineDistance(points[point_id], safe_point.Point) / speed_at(point_id);
+    if (time < time_to_safety[point_id]) {
+      time_to_safety[point_id] = time;
+      order.push({time, point_id});
+    }
+  }
+
+  while (!order.empty()) {
+    const auto [time, point_id] = order.top();
+    order.pop();
+    if (time_to_safety[point_id] != time) {
+      continue;
+    }
+    for (const auto& adjency_point_id : grid->GetAdjencyPointIds(point_id)) {
+      const double adjency_time = time +
+          common::GetHaversineDistance(points[adjency_point_id], points[point_id]) / speed_at(adjency_point_id);
+      if (adjency_time < time_to_safety[adjency_point_id]) {
+        time_to_safety[adjency_point_id] = adjency_time;
+        order.push({adjency_time, adjency_point_id});
+      }
+    }
+  }
+
+  return SafetyField(grid, std::move(time_to_safety));
+}
+
+}  // namespace marine_navi::cases::helpers
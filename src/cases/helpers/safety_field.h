@@ -0,0 +1,34 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "entities/find_route_grid.h"
+#include "entities/safe_point.h"
+
+namespace marine_navi::cases::helpers {
+
+// Time to reach the nearest safe point from every node of the grid
+class SafetyField {
+public:
+  SafetyField(std::shared_ptr<const entities::FindRouteGrid> grid,
+              std::vector<double> time_to_safety);
+
+  // @return time in seconds, std::nullopt if the point is outside of grid or no safe point is reachable
+  std::optional<double> GetTimeToSafety(common::Point point) const;
+  std::optional<double> GetTimeToSafety(int point_id) const;
+
+private:
+  const std::shared_ptr<const entities::FindRouteGrid> grid_;
+  const std::vector<double> time_to_safety_;
+};
+
+// Runs single multi-source search from all safe points over reversed grid edges.
+// @param speed_at speed in m/s of the ship leaving the grid node
+SafetyField BuildSafetyField(std::shared_ptr<const entities::FindRouteGrid> grid,
+                             const std::vector<entities::SafePoint>& safe_points,
+                             const std::function<double(int)>& speed_at);
+
+}  // namespace marine_navi::cases::helpers
@@ -0,0 +1,200 @@
+#include "shoal_tracer.h"
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <unordered_map>
+
+namespace marine_navi::cases::helpers {
+
+namespace {
+
+// simplification tolerance in cells, the isobath position between samples is an estimate anyway
+constexpr double kToleranceCells = 0.5;
+
+// Depth samples padded with a border of deep water, so every isobath is a closed ring
+class PaddedSamples {
+public:
+  PaddedSamples(const entities::DepthGrid& grid, double draft)
+      : grid_(grid), geometry_(grid.GetGeometry()), level_(-draft) {}
+
+  uint32_t GetRows() const { return geometry_.n_rows + 2; }
+  uint32_t GetCols() const { return geometry_.n_cols + 2; }
+
+  // depth is elevation, shallow samples are not lower than -draft
+  double GetValue(uint32_t row, uint32_t col) const {
+    if (row == 0 || col == 0 || row > geometry_.n_rows || col > geometry_.n_cols) {
+      return -std::numeric_limits<double>::infinity();
+    }
+    return grid_.GetSampleDepth(row - 1, col - 1);
+  }
+  bool IsInside(uint32_t row, uint32_t col) const { return GetValue(row, col) >= level_; }
+  double GetLevel() const { return level_; }
+
+  common::Point GetPoint(double row, double col) const {
+    return common::Point{
+      geometry_.min_lat + (row - 1) * geometry_.cell_size,
+      geometry_.min_lon + (col - 1) * geometry_.cell_size,
+    };
+  }
+
+  // horizontal edge joins (row, col) and (row, col + 1), vertical one joins (row, col) and (row + 1, col)
+  int64_t GetEdgeId(uint32_t row, uint32_t col, bool vertical) const {
+    return (static_cast<int64_t>(row) * GetCols() + col) * 2 + (vertical ? 1 : 0);
+  }
+
+  common::Point GetCrossing(int64_t edge_id) const {
+    const bool vertical = edge_id % 2 == 1;
+    const uint32_t row = (edge_id / 2) / GetCols();
+    const uint32_t col = (edge_id / 2) % GetCols();
+    const double a = GetValue(row, col);
+    const double b = vertical ? GetValue(row + 1, col) : GetValue(row, col + 1);
+    double t = 0.5;
+    if (std::isfinite(a) && std::isfinite(b) && a != b) {
+      t = (level_ - a) / (b - a);
+    }
+    return vertical ? GetPoint(row + t, col) : GetPoint(row, col + t);
+  }
+
+private:
+  const entities::DepthGrid& grid_;
+  const entities::RasterGeometry geometry_;
+  const double level_;
+};
+
+// @return rings with shallow water on the left: outer rings are counterclockwise, holes are clockwise
+std::vector<common::Polygon> TraceRings(const PaddedSamples& samples) {
+  std::unordered_map<int64_t, int64_t> next_edge;
+
+  for (uint32_t row = 0; row + 1 < samples.GetRows(); ++row) {
+    for (uint32_t col = 0; col + 1 < samples.GetCols(); ++col) {
+      // corners and edges in counterclockwise order starting from the bottom left corner
+      const std::array<bool, 4> inside = {
+        samples.IsInside(row, col), samples.IsInside(row, col + 1),
+        samples.IsInside(row + 1, col + 1), samples.IsInside(row + 1, col),
+      };
+      const std::array<int64_t, 4> edges = {
+        samples.GetEdgeId(row, col, false), samples.GetEdgeId(row, col + 1, true),
+        samples.GetEdgeId(row + 1, col, false), samples.GetEdgeId(row, col, true),
+      };
+
+      std::array<int, 4> crossings;
+      size_t crossing_count = 0;
+      for (int i = 0; i < 4; ++i) {
+        if (inside[i] != inside[(i + 1) % 4]) {
+          crossings[crossing_count++] = i;
+        }
+      }
+      if (crossing_count == 0) {
+        continue;
+      }
+
+      // leaving crossing goes to the entering one that closes the same shallow corner,
+      // for saddles it depends on whether the cell center is shallow
+      bool center_inside = false;
+      if (crossing_count == 4) {
+        const double center = (samples.GetValue(row, col) + samples.GetValue(row, col + 1) +
+                               samples.GetValue(row + 1, col + 1) + samples.GetValue(row + 1, col)) / 4;
+        center_inside = center >= samples.GetLevel();
+      }
+      for (size_t i = 0; i < crossing_count; ++i) {
+        const int edge = crossings[i];
+        if (!inside[edge]) {
+          continue;
+        }
+        const size_t target = center_inside ? (i + 1) % crossing_count
+                                            : (i + crossing_count - 1) % crossing_count;
+        next_edge[edges[edge]] = edges[crossings[target]];
+      }
+    }
+  }
+
+  std::vector<common::Polygon> rings;
+  while (!next_edge.empty()) {
+    const int64_t start = next_edge.begin()->first;
+    common::Polygon ring;
+    int64_t edge = start;
+    do {
+      ring.Points.push_back(samples.GetCrossing(edge));
+      const auto it = next_edge.find(edge);
+      edge = it->second;
+      next_edge.erase(it);
+    } while (edge != start);
+    rings.push_back(std::move(ring));
+  }
+  return rings;
+}
+
+struct Bounds {
+  double min_lat, min_lon, max_lat, max_lon;
+
+  bool Contains(const common::Point& point) const {
+    return min_lat <= point.Lat && point.Lat <= max_lat && min_lon <= point.Lon && point.Lon <= max_lon;
+  }
+};
+
+Bounds GetBounds(const common::Polygon& ring) {
+  Bounds bounds{ring.Points[0].Lat, ring.Points[0].Lon, ring.Points[0].Lat, ring.Points[0].Lon};
+  for (const auto& point : ring.Points) {
+    bounds.min_lat = std::min(bounds.min_lat, point.Lat);
+    bounds.min_lon = std::min(bounds.min_lon, point.Lon);
+    bounds.max_lat = std::max(bounds.max_lat, point.Lat);
+    bounds.max_lon = std::max(bounds.max_lon, point.Lon);
+  }
+  return bounds;
+}
+
+}  // namespace
+
+std::vector<entities::ShoalPolygon> TraceShoalPolygons(const entities::DepthGrid& grid, double draft) {
+  const PaddedSamples samples(grid, draft);
+  const auto rings = TraceRings(samples);
+
+  std::vector<size_t> outer_ids;
+  std::vector<size_t> hole_ids;
+  std::vector<double> areas(rings.size());
+  std::vector<Bounds> bounds(rings.size());
+  for (size_t i = 0; i < rings.size(); ++i) {
+    areas[i] = common::GetSignedArea(rings[i]);
+    bounds[i] = GetBounds(rings[i]);
+    (areas[i] > 0 ? outer_ids : hole_ids).push_back(i);
+  }
+
+  // isobaths never cross, so a hole belongs to the smallest outer ring around its vertex
+  std::vector<std::vector<size_t>> holes_of_outer(rings.size());
+  for (const size_t hole_id : hole_ids) {
+    const auto& vertex = rings[hole_id].Points[0];
+    std::optional<size_t> parent;
+    for (const size_t outer_id : outer_ids) {
+      if (!bounds[outer_id].Contains(vertex) ||
+          (parent.has_value() && areas[outer_id] >= areas[parent.value()]) ||
+          !common::IsInsidePolygon(vertex, rings[outer_id])) {
+        continue;
+      }
+      parent = outer_id;
+    }
+    if (parent.has_value()) {
+      holes_of_outer[parent.value()].push_back(hole_id);
+    }
+  }
+
+  const double tolerance = kToleranceCells * grid.GetGeometry().cell_size;
+  std::vector<entities::ShoalPolygon> result;
+  result.reserve(outer_ids.size());
+  for (const size_t outer_id : outer_ids) {
+    entities::ShoalPolygon polygon{
+      .draft = draft,
+      .outer = common::SimplifyRing(rings[outer_id], tolerance),
+      .holes = {},
+      .tolerance = tolerance,
+    };
+    for (const size_t hole_id : holes_of_outer[outer_id]) {
+      polygon.holes.push_back(common::SimplifyRing(rings[hole_id], tolerance));
+    }
+    result.push_back(std::move(polygon));
+  }
+  return result;
+}
+
+}  // namespace marine_navi::cases::helpers
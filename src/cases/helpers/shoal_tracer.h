@@ -0,0 +1,14 @@
+#pragma once
+
+#include <vector>
+
+#include "entities/depth_grid.h"
+#include "entities/shoal_polygon.h"
+
+namespace marine_navi::cases::helpers {
+
+// Traces isobath of the draft over depth samples with marching squares and returns simplified
+// shoal polygons with their holes. Samples outside of the grid are treated as deep water.
+std::vector<entities::ShoalPolygon> TraceShoalPolygons(const entities::DepthGrid& grid, double draft);
+
+}  // namespace marine_navi::cases::helpers
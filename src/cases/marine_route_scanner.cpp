@@ -1,7 +1,15 @@
 #include "marine_route_scanner.h"
 
+#include <unordered_set>
+
+#include <wx/log.h>
+
+#include "cases/helpers/corridor.h"
 #include "cases/helpers/forecast_accessor.h"
+#include "cases/helpers/hazard_clustering.h"
 #include "cases/helpers/route_helpers.h"
+#include "cases/helpers/route_sampling.h"
+#include "common/hash.h"
 #include "common/marine_math.h"
 #include "entities/depth_point.h"
 
@@ -9,16 +17,68 @@ namespace marine_navi::cases {
 
 namespace {
 
+// sample step when the forecast grid spacing is unknown
+constexpr double kForecastStepMeters = 10000;
+// samples are not denser near dangers, the precision of the danger distance field
+constexpr double kMinSampleStepMeters = 1000;
+// midpoints are sampled between neighbouring samples whose highest waves differ more
+constexpr double kMaxWaveHeightChange = 0.5;
+constexpr double kDangerousDistanceRad = 0.1;
+// length of corridor tiles checked for depths, each one is a separate spatial index lookup
+constexpr double kCorridorTileMeters = 5000;
+// hazards closer than this are shown as one marker
+constexpr double kHazardClusterCellMeters = 10000;
+// a streamed detection queries the route in parts of at least this length
+constexpr double kStreamPartMeters = 50000;
+// cached query results are dropped when this many segments are kept
+constexpr size_t kMaxCachedSegments = 100000;
+// monitoring rescans the rest of the route when own ship is this late or early
+constexpr time_t kMaxEtaShift = 15 * 60;
+// a part of persisted result keys, changes of the detection make stored results unreachable
+constexpr int64_t kScanResultVersion = 2;
+// the departure window queries forecasts up to the last departure and this many passages at full speed
+constexpr double kPassageTimeMargin = 2;
+
+// Samples follow the forecast grid in open water. The query radius is in degrees, so it shrinks to the
+// east with latitude, and samples at most radius * sqrt(3) apart see every forecast location within
+// half of the radius from the segment.
+helpers::SampleStepLimits GetSampleStepLimits(const common::Segment& segment, std::optional<double> grid_spacing) {
+  const double max_lat = std::max(std::abs(segment.Start.Lat), std::abs(segment.End.Lat));
+  const double coverage_step = kDangerousDistanceRad * common::kMetersPerDegree * std::cos(max_lat * M_PI / 180) * std::sqrt(3.0);
+  return helpers::SampleStepLimits{
+    .min_step = kMinSampleStepMeters,
+    .max_step = std::max(std::min(grid_spacing.value_or(kForecastStepMeters), coverage_step), kMinSampleStepMeters),
+  };
+}
 
-std::vector<entities::RoutePoint> GetRoutePoints(const std::shared_ptr<entities::Route>& route, double step_dist) {
-  std::vector<entities::RoutePoint> result;
-  
-  double total = route->GetDistance();
+uint64_t GetSegmentHash(const common::Segment& segment) {
+  return common::Hasher().Add(segment.Start).Add(segment.End).Get();
+}
 
-  for (size_t i = 0; i * step_dist < total; ++i) {
-    result.emplace_back(route->GetPointFromStart(i * step_dist));
+// @return key of the persisted check result, it changes with the route geometry, the ship, the departure
+// and the loaded data
+std::string MakeScanResultKey(const RouteScannerInput& route_data, int64_t forecast_id,
+                              std::optional<uint64_t> depth_version) {
+  common::Hasher hasher;
+  hasher.Add(kScanResultVersion);
+  for (const auto& segment : route_data.Route->GetSegments()) {
+    hasher.Add(segment.segment.Start).Add(segment.segment.End);
   }
-  return result;
+  const auto& ship = route_data.ShipPerformanceInfo;
+  for (const auto value : {ship.DangerHeight, ship.EnginePower, ship.Displacement, ship.Length,
+                           ship.Fullness, ship.Speed, ship.ShipDraft}) {
+    hasher.Add(static_cast<int64_t>(value.has_value())).Add(value.value_or(0));
+  }
+  hasher.Add(static_cast<int64_t>(route_data.DepartTime)).Add(forecast_id);
+  hasher.Add(static_cast<int64_t>(depth_version.has_value()))
+        .Add(static_cast<int64_t>(depth_version.value_or(0)));
+  return common::ToHexString(hasher.Get());
+}
+
+void LogArenaStats(const char* scan, const common::Arena& arena) {
+  const auto stats = arena.GetStats();
+  wxLogInfo(_T("%s arena: %zu allocations, %zu bytes in %zu blocks"),
+            scan, stats.allocation_count, stats.allocated_bytes, stats.block_count);
 }
 
 [[maybe_unused]] bool IsPointOnRoute(const common::Segment& segment, const common::Point point, double alpha) {
@@ -29,100 +89,451 @@ std::vector<entities::RoutePoint> GetRoutePoints(const std::shared_ptr<entities:
          common::IsInsideOfAngle(direction, point_vec, direction.Rotate(-alpha));
 }
 
-std::tuple<common::Polygon, common::Polygon> MakeDepthCheckPolygon(const common::Segment& segment, double alpha) {
-  const auto direction = segment.End - segment.Start;
-  const auto poly1 = common::Polygon{
-    {segment.Start, segment.End, segment.Start + direction.Rotate(alpha)},
-  };
-  const auto poly2 = common::Polygon{
-    {segment.Start, segment.End, segment.Start + direction.Rotate(-alpha)}, 
-  };
-
-  return {poly1, poly2};
-}
-
-std::vector<entities::diagnostic::DiagnosticHazardPoint> FilterDiagnosticPoints(
-  const std::vector<entities::diagnostic::DiagnosticHazardPoint>& points, double distance_between_points) {
-  std::vector<entities::diagnostic::DiagnosticHazardPoint> result;
-
-  for(const auto& point : points) {
-    if (result.size() == 0 
-        || common::GetHaversineDistance(result.back().GetLocation(), point.GetLocation()) >= distance_between_points) {
-      result.push_back(point);
-    }
+// @return expected time at distance along the route, linear between the scanned points
+time_t InterpolateExpectedTime(const std::vector<std::pair<double, time_t>>& eta, double distance) {
+  const auto it = std::lower_bound(eta.begin(), eta.end(), distance,
+    [](const std::pair<double, time_t>& point, double value) { return point.first < value; });
+  if (it == eta.begin()) {
+    return eta.front().second;
   }
-  return result;
+  if (it == eta.end()) {
+    return eta.back().second;
+  }
+  const auto& [prev_distance, prev_time] = *std::prev(it);
+  const double k = it->first > prev_distance ? (distance - prev_distance) / (it->first - prev_distance) : 0;
+  return prev_time + static_cast<time_t>((it->second - prev_time) * k);
 }
 
 } // namespace
 
-MarineRouteScanner::MarineRouteScanner(std::shared_ptr<clients::DbClient> dbClient)
-    : mutex_(), route_data_(), show_(false), db_client_(dbClient) {}
+MarineRouteScanner::MarineRouteScanner(std::shared_ptr<clients::DbClient> dbClient,
+                                       std::shared_ptr<DepthMaskProvider> depth_mask_provider,
+                                       std::shared_ptr<common::ThreadPool> thread_pool)
+    : mutex_(),
+      snapshot_(std::make_shared<const RouteScannerSnapshot>(RouteScannerSnapshot{
+        .version = 0,
+        .route_data = {},
+        .show = false,
+        .diagnostic = nullptr,
+        .detection_id = 0,
+        .partial = false,
+      })),
+      db_client_(dbClient), depth_mask_provider_(depth_mask_provider),
+      thread_pool_(thread_pool), detect_generation_(0),
+      monitor_mutex_(), monitor_callback_(), monitor_fix_(), monitor_update_queued_(false),
+      forecast_spacing_mutex_(), forecast_spacing_(),
+      scan_mutex_(), scan_cache_(), depth_profile_mutex_(), depth_profiles_(), detect_worker_(1) {}
 
 void MarineRouteScanner::SetPathData(const RouteScannerInput& pathData) {
   std::lock_guard lock(mutex_);
-  route_data_ = pathData;
+  Publish([&](RouteScannerSnapshot& snapshot) { snapshot.route_data = pathData; });
 }
 
-const RouteScannerInput& MarineRouteScanner::GetPathData() {
+void MarineRouteScanner::SetShow(bool show) {
   std::lock_guard lock(mutex_);
-  return route_data_;
+  Publish([&](RouteScannerSnapshot& snapshot) { snapshot.show = show; });
 }
 
-void MarineRouteScanner::SetShow(bool show) {
-  std::lock_guard lock(mutex_);
-  show_ = show;
+std::shared_ptr<const RouteScannerSnapshot> MarineRouteScanner::GetSnapshot() const {
+  return std::atomic_load(&snapshot_);
 }
 
-bool MarineRouteScanner::IsShow() {
-  std::lock_guard lock(mutex_);
-  return show_;
+void MarineRouteScanner::Publish(const std::function<void(RouteScannerSnapshot&)>& update) {
+  auto snapshot = std::make_shared<RouteScannerSnapshot>(*std::atomic_load(&snapshot_));
+  update(*snapshot);
+  ++snapshot->version;
+  std::atomic_store(&snapshot_, std::shared_ptr<const RouteScannerSnapshot>(std::move(snapshot)));
 }
 
-std::optional<entities::diagnostic::RouteValidateDiagnostic> MarineRouteScanner::GetDiagnostic() {
-  std::lock_guard lock(mutex_);
-  return diagnostic_;
+void MarineRouteScanner::CrossDetectAsync(DetectCallback on_finished, HazardsCallback on_hazards) {
+  detect_worker_.Submit([this, on_finished = std::move(on_finished), on_hazards = std::move(on_hazards)] {
+    on_finished(RunCrossDetect(on_hazards));
+  });
 }
 
-void MarineRouteScanner::CrossDetect() {
-  std::lock_guard lock(mutex_);
-  fprintf(stderr, "Cross detect\n");
+std::optional<MarineRouteScanner::Diagnostic> MarineRouteScanner::RunCrossDetect(const HazardsCallback& on_hazards) {
+  // the lock is not held while detecting, so readers are never blocked by database queries
+  RouteScannerInput route_data;
+  uint64_t generation;
+  {
+    std::lock_guard lock(mutex_);
+    route_data = GetSnapshot()->route_data;
+    generation = ++detect_generation_;
+  }
 
+  // hazards of the scanned parts are published as a warning, the complete diagnostic replaces them
+  HazardsCallback publish_hazards;
+  if (on_hazards) {
+    publish_hazards = [&](std::vector<entities::diagnostic::DiagnosticHazardPoint> hazard_points) {
+      if (!hazard_points.empty()) {
+        std::lock_guard lock(mutex_);
+        if (generation == detect_generation_) {
+          Publish([&](RouteScannerSnapshot& snapshot) {
+            auto diagnostic = Diagnostic{Diagnostic::DiagnosticResultType::kWarning, {}};
+            if (snapshot.partial && snapshot.detection_id == generation && snapshot.diagnostic != nullptr) {
+              diagnostic.hazard_points = snapshot.diagnostic->hazard_points;
+            }
+            diagnostic.hazard_points.insert(diagnostic.hazard_points.end(), hazard_points.begin(), hazard_points.end());
+            snapshot.diagnostic = std::make_shared<const Diagnostic>(std::move(diagnostic));
+            snapshot.detection_id = generation;
+            snapshot.partial = true;
+          });
+        }
+      }
+      on_hazards(std::move(hazard_points));
+    };
+  }
+
+  std::optional<Diagnostic> diagnostic;
   try {
-    diagnostic_ = DoCrossDetect();
+    diagnostic = DoCrossDetect(route_data, publish_hazards);
   } catch (std::exception& ex) {
     fprintf(stderr, "Failed detect impl %s\n", ex.what());
-    diagnostic_ = std::nullopt;  // TODO: signal about it
   }
+
+  std::lock_guard lock(mutex_);
+  if (generation == detect_generation_) {
+    Publish([&](RouteScannerSnapshot& snapshot) {
+      snapshot.diagnostic = diagnostic.has_value() ? std::make_shared<const Diagnostic>(diagnostic.value()) : nullptr;
+      snapshot.detection_id = generation;
+      snapshot.partial = false;
+    });
+  }
+  return diagnostic;
+}
+
+void MarineRouteScanner::StartMonitoring(DetectCallback on_update) {
+  std::lock_guard lock(monitor_mutex_);
+  monitor_callback_ = std::move(on_update);
+}
+
+void MarineRouteScanner::StopMonitoring() {
+  std::lock_guard lock(monitor_mutex_);
+  monitor_callback_ = nullptr;
+  monitor_fix_.reset();
+}
+
+void MarineRouteScanner::UpdateOwnShipPosition(const Point& position, time_t fix_time) {
+  std::lock_guard lock(monitor_mutex_);
+  if (!monitor_callback_) {
+    return;
+  }
+  monitor_fix_ = OwnShipFix{position, fix_time};
+  if (monitor_update_queued_) {
+    return;
+  }
+  monitor_update_queued_ = true;
+  detect_worker_.Submit([this] { RunMonitorUpdate(); });
+}
+
+void MarineRouteScanner::RunMonitorUpdate() {
+  std::optional<OwnShipFix> fix;
+  DetectCallback on_update;
+  {
+    std::lock_guard lock(monitor_mutex_);
+    monitor_update_queued_ = false;
+    std::swap(fix, monitor_fix_);
+    on_update = monitor_callback_;
+  }
+  const auto route_data = GetSnapshot()->route_data;
+  if (!fix.has_value() || !on_update || route_data.Route == nullptr || route_data.Route->GetSegments().empty()) {
+    return;
+  }
+
+  try {
+    if (!UpdateMonitorDiagnostic(route_data, fix.value())) {
+      return;
+    }
+  } catch (std::exception& ex) {
+    wxLogError(_T("Failed to update the monitored route with reason: %s"), ex.what());
+    monitor_eta_.clear();
+    monitor_diagnostic_.reset();
+  }
+  const auto diagnostic = monitor_diagnostic_;
+
+  {
+    std::lock_guard lock(mutex_);
+    const uint64_t generation = ++detect_generation_;
+    Publish([&](RouteScannerSnapshot& snapshot) {
+      snapshot.diagnostic = diagnostic.has_value() ? std::make_shared<const Diagnostic>(diagnostic.value()) : nullptr;
+      snapshot.detection_id = generation;
+      snapshot.partial = false;
+    });
+  }
+  on_update(diagnostic);
+}
+
+bool MarineRouteScanner::UpdateMonitorDiagnostic(const RouteScannerInput& route_data, const OwnShipFix& fix) {
+  std::lock_guard lock(scan_mutex_);
+
+  const bool rescan = !ValidateScanCache(route_data) || monitor_route_ != route_data.Route ||
+                      monitor_eta_.empty() || !monitor_diagnostic_.has_value();
+  const double distance = route_data.Route->GetClosestDistanceFromStart(fix.position);
+  if (!rescan && std::abs(fix.time - InterpolateExpectedTime(monitor_eta_, distance)) <= kMaxEtaShift) {
+    // the schedule holds, only hazards which are already passed are dropped, a cluster is kept until its last hazard
+    auto& hazard_points = monitor_diagnostic_->hazard_points;
+    const size_t hazard_count = hazard_points.size();
+    hazard_points.erase(std::remove_if(hazard_points.begin(), hazard_points.end(),
+      [&fix](const entities::diagnostic::DiagnosticHazardPoint& point) { return point.GetLastExpectedTime() < fix.time; }),
+      hazard_points.end());
+    if (hazard_points.empty()) {
+      monitor_diagnostic_->result = Diagnostic::DiagnosticResultType::kOk;
+    }
+    return hazard_points.size() != hazard_count;
+  }
+
+  // the forecast window follows own ship rather than the departure, waves slow the ship down, so the rest of
+  // the passage at full speed is taken with a margin. A window covering the needed one is reused
+  const auto max_forecast_time = fix.time + static_cast<time_t>(
+      kPassageTimeMargin * (route_data.Route->GetDistance() - distance) / route_data.ShipPerformanceInfo.Speed.value());
+  auto& monitor_forecasts = scan_cache_->monitor_forecasts;
+  if (!monitor_forecasts.has_value() || monitor_forecasts->min_time > fix.time ||
+      monitor_forecasts->max_time < max_forecast_time) {
+    monitor_forecasts = MonitorForecasts{
+      .min_time = fix.time,
+      .max_time = max_forecast_time,
+      .segment_forecasts = {},
+    };
+  }
+
+  auto& forecasts = monitor_forecasts->segment_forecasts;
+  common::Arena arena;
+  FetchSegmentForecasts({route_data.Route}, monitor_forecasts->min_time,
+                        route_data.ShipPerformanceInfo.ShipDraft.value(), forecasts, monitor_forecasts->max_time);
+  auto route_info = GetRouteInfo(route_data, ScanStart{distance, fix.time}, forecasts, &arena);
+  monitor_route_ = route_data.Route;
+  monitor_eta_.clear();
+  for (const auto& point : route_info) {
+    monitor_eta_.emplace_back(point.route_point.distance_from_start_route, point.expected_time);
+  }
+  monitor_diagnostic_ = MakeDiagnostic(route_data, std::move(route_info), &arena);
+  LogArenaStats("Monitor rescan", arena);
+  return true;
 }
 
-std::vector<MarineRouteScanner::RoutePointWithForecast> MarineRouteScanner::GetRouteInfo() const {
-  const double kForecastStepMeters = 10000;
-  const double kDangerousDistanceRad = 0.1;
+bool MarineRouteScanner::ValidateScanCache(const RouteScannerInput& route_data) {
+  const double draft = route_data.ShipPerformanceInfo.ShipDraft.value();
+  const int64_t forecast_id = db_client_->SelectLastForecastId();
+  const auto depth_version = depth_mask_provider_->GetVersion();
+
+  if (!scan_cache_.has_value() || scan_cache_->depart_time != route_data.DepartTime || scan_cache_->draft != draft) {
+    scan_cache_ = ScanCache{
+      .depart_time = route_data.DepartTime,
+      .draft = draft,
+      .forecast_id = forecast_id,
+      .depth_version = depth_version,
+      .segment_forecasts = {},
+      .monitor_forecasts = std::nullopt,
+    };
+    return false;
+  }
 
-  const auto route_points = GetRoutePoints(route_data_.Route, kForecastStepMeters);
-  std::vector<common::Point> points;
-  std::transform(route_points.begin(), route_points.end(), std::back_inserter(points),
-                 [](const entities::RoutePoint& route_point) { return route_point.point; });
-  const auto min_get_time = route_data_.DepartTime - 3*60*60;
-  auto forecasts = db_client_->SelectClosestForecasts(points, kDangerousDistanceRad, min_get_time);
-  const auto forecast_accessor = helpers::ForecastAccessor(forecasts);
+  bool valid = true;
+  if (scan_cache_->forecast_id != forecast_id) {
+    scan_cache_->forecast_id = forecast_id;
+    scan_cache_->segment_forecasts.clear();
+    scan_cache_->monitor_forecasts.reset();
+    valid = false;
+  }
+  // depth profiles are dropped by GetDepthProfiles, monitoring only needs to know about the change
+  if (scan_cache_->depth_version != depth_version) {
+    scan_cache_->depth_version = depth_version;
+    valid = false;
+  }
+  if (scan_cache_->segment_forecasts.size() > kMaxCachedSegments) {
+    scan_cache_->segment_forecasts.clear();
+  }
+  if (scan_cache_->monitor_forecasts.has_value() &&
+      scan_cache_->monitor_forecasts->segment_forecasts.size() > kMaxCachedSegments) {
+    scan_cache_->monitor_forecasts.reset();
+  }
+  return valid;
+}
 
-  time_t cur_time = route_data_.DepartTime;
-  double cur_speed = route_data_.ShipPerformanceInfo.Speed.value();
+std::optional<double> MarineRouteScanner::GetForecastGridSpacing() {
+  const int64_t forecast_id = db_client_->SelectLastForecastId();
+  std::lock_guard lock(forecast_spacing_mutex_);
+  if (!forecast_spacing_.has_value() || forecast_spacing_->first != forecast_id) {
+    // the step between grid rows, longitude steps shrink in meters with latitude
+    const auto grid_step = helpers::GetGridStep(db_client_->SelectForecastLatitudes(forecast_id));
+    forecast_spacing_.emplace(forecast_id, grid_step.has_value()
+      ? std::optional<double>(grid_step.value() * common::kMetersPerDegree)
+      : std::nullopt);
+  }
+  return forecast_spacing_->second;
+}
 
-  std::vector<MarineRouteScanner::RoutePointWithForecast> result;
+void MarineRouteScanner::FetchSegmentForecasts(
+    const std::vector<std::shared_ptr<entities::Route>>& routes,
+    time_t depart_time, double draft,
+    SegmentForecasts& cache,
+    std::optional<time_t> max_forecast_time) {
+  // route and segment index of every missing segment, a segment shared by routes is queried once
+  std::vector<std::pair<const entities::Route*, size_t>> segments;
+  std::vector<uint64_t> segment_keys;
+  std::unordered_set<uint64_t> missing_keys;
+  for (const auto& route : routes) {
+    for (size_t i = 0; i < route->GetSegments().size(); ++i) {
+      const auto key = GetSegmentHash(route->GetSegments()[i].segment);
+      if (cache.find(key) == cache.end() && missing_keys.insert(key).second) {
+        segments.emplace_back(route.get(), i);
+        segment_keys.push_back(key);
+      }
+    }
+  }
+  if (segments.empty()) {
+    return;
+  }
+
+  const auto min_get_time = depart_time - 3*60*60;
+  // @return forecasts of the points at offsets of every segment, ids are offset indices
+  auto select_forecasts = [&](const std::vector<std::vector<double>>& segment_offsets) {
+    std::vector<common::Point> points;
+    std::vector<std::pair<size_t, int>> point_samples;
+    for (size_t i = 0; i < segments.size(); ++i) {
+      const auto& [route, segment_id] = segments[i];
+      for (size_t j = 0; j < segment_offsets[i].size(); ++j) {
+        points.push_back(route->GetSegmentPoint(segment_id, segment_offsets[i][j]).point);
+        point_samples.emplace_back(i, static_cast<int>(j));
+      }
+    }
+    std::vector<ClosestForecasts> result(segments.size());
+    if (points.empty()) {
+      return result;
+    }
+    for (auto& forecast : db_client_->SelectClosestForecasts(points, kDangerousDistanceRad, min_get_time,
+                                                                  max_forecast_time)) {
+      const auto& [segment_index, sample_id] = point_samples[std::get<2>(forecast)];
+      std::get<2>(forecast) = sample_id;
+      result[segment_index].push_back(std::move(forecast));
+    }
+    return result;
+  };
+
+  const auto grid_spacing = GetForecastGridSpacing();
+  const auto distance_field = depth_mask_provider_->GetDangerDistanceField(draft);
+  std::vector<std::vector<double>> offsets(segments.size());
+  for (size_t i = 0; i < segments.size(); ++i) {
+    const auto& segment = segments[i].first->GetSegments()[segments[i].second];
+    offsets[i] = helpers::SampleSegment(segment, distance_field.get(), GetSampleStepLimits(segment.segment, grid_spacing));
+  }
+  auto forecasts = select_forecasts(offsets);
+
+  // the highest waves of neighbouring samples are compared, so refinement does not depend on the departure
+  std::vector<std::vector<double>> refined_offsets(segments.size());
+  for (size_t i = 0; i < segments.size(); ++i) {
+    std::vector<std::optional<double>> max_wave_heights(offsets[i].size());
+    for (const auto& [forecast, distance, sample_id] : forecasts[i]) {
+      auto& height = max_wave_heights[sample_id];
+      height = std::max(height.value_or(forecast.GetWaveHeight()), forecast.GetWaveHeight());
+    }
+    refined_offsets[i] = helpers::FindRefinedOffsets(
+      offsets[i], max_wave_heights, kMaxWaveHeightChange, kMinSampleStepMeters);
+  }
+  auto refined_forecasts = select_forecasts(refined_offsets);
+
+  // segments without forecasts are cached too
+  for (size_t i = 0; i < segments.size(); ++i) {
+    const size_t sample_count = offsets[i].size();
+    std::vector<std::pair<double, size_t>> order;
+    for (size_t j = 0; j < sample_count; ++j) {
+      order.emplace_back(offsets[i][j], j);
+    }
+    for (size_t j = 0; j < refined_offsets[i].size(); ++j) {
+      order.emplace_back(refined_offsets[i][j], sample_count + j);
+    }
+    std::sort(order.begin(), order.end());
+
+    SegmentSamples samples;
+    std::vector<int> sample_ids(order.size());
+    for (size_t j = 0; j < order.size(); ++j) {
+      samples.offsets.push_back(order[j].first);
+      sample_ids[order[j].second] = static_cast<int>(j);
+    }
+    for (auto& forecast : forecasts[i]) {
+      std::get<2>(forecast) = sample_ids[std::get<2>(forecast)];
+      samples.forecasts.push_back(std::move(forecast));
+    }
+    for (auto& forecast : refined_forecasts[i]) {
+      std::get<2>(forecast) = sample_ids[sample_count + std::get<2>(forecast)];
+      samples.forecasts.push_back(std::move(forecast));
+    }
+    cache.emplace(segment_keys[i], std::move(samples));
+  }
+}
+
+MarineRouteScanner::RouteSamples MarineRouteScanner::GetRouteSamples(
+    const entities::Route& route,
+    const SegmentForecasts& cache,
+    std::pmr::memory_resource* memory) const {
+  std::pmr::vector<entities::RoutePoint> samples(memory);
+  ClosestForecasts forecasts;
+  const auto& segments = route.GetSegments();
+  for (size_t i = 0; i < segments.size(); ++i) {
+    const auto& segment_samples = cache.at(GetSegmentHash(segments[i].segment));
+    const int first_sample_id = static_cast<int>(samples.size());
+    for (const double offset : segment_samples.offsets) {
+      samples.push_back(route.GetSegmentPoint(i, offset));
+    }
+    for (auto forecast : segment_samples.forecasts) {
+      std::get<2>(forecast) += first_sample_id;
+      forecasts.push_back(std::move(forecast));
+    }
+  }
+  return RouteSamples{std::move(samples), helpers::ForecastAccessor(forecasts)};
+}
+
+MarineRouteScanner::RouteInfo MarineRouteScanner::GetRouteInfo(
+    const RouteScannerInput& route_data,
+    const ScanStart& start,
+    const SegmentForecasts& cache,
+    std::pmr::memory_resource* memory) const {
+  return PropagateRoute(route_data, start, GetRouteSamples(*route_data.Route, cache, memory), memory);
+}
+
+MarineRouteScanner::RouteInfo MarineRouteScanner::PropagateRoute(
+    const RouteScannerInput& route_data,
+    const ScanStart& start,
+    const RouteSamples& route_samples,
+    std::pmr::memory_resource* memory) const {
+  const auto& samples = route_samples.points;
+  if (samples.empty()) {
+    return RouteInfo(memory);
+  }
+  const auto& forecast_accessor = route_samples.forecasts;
+
+  // the start point uses forecasts of the previous sample, forecast ids are sample indices
+  const auto next_sample = std::upper_bound(samples.begin(), samples.end(), start.distance,
+    [](double value, const entities::RoutePoint& sample) { return value < sample.distance_from_start_route; });
+  const size_t start_sample_id = next_sample == samples.begin() ? 0 : next_sample - samples.begin() - 1;
+  auto start_point = route_data.Route->GetPointFromStart(start.distance);
+  if (start_point.segment_id != samples[start_sample_id].segment_id) {
+    // the start is exactly on a waypoint, it begins the next segment
+    start_point = samples[start_sample_id];
+  }
+  std::pmr::vector<std::pair<entities::RoutePoint, size_t>> route_points(memory);
+  route_points.reserve(samples.size() - start_sample_id);
+  route_points.emplace_back(start_point, start_sample_id);
+  for (size_t i = next_sample - samples.begin(); i < samples.size(); ++i) {
+    route_points.emplace_back(samples[i], i);
+  }
+
+  time_t cur_time = start.time;
+  double cur_speed = route_data.ShipPerformanceInfo.Speed.value();
+
+  RouteInfo result(memory);
+  result.reserve(route_points.size());
 
   for(size_t i = 0; i < route_points.size(); ++i) {
-    const auto& route_point = route_points[i];
-    const auto closest_forecast = forecast_accessor.GetClosestForecast(i, cur_time);
+    const auto& [route_point, sample_id] = route_points[i];
+    const auto closest_forecast = forecast_accessor.GetClosestForecast(sample_id, cur_time);
 
     if (closest_forecast.has_value()) {
-      cur_speed = helpers::GetSpeed(route_data_.ShipPerformanceInfo, closest_forecast->GetWaveHeight());
+      cur_speed = helpers::GetSpeed(route_data.ShipPerformanceInfo, closest_forecast->GetWaveHeight());
     }
 
     if (i > 0) {
-      const auto& previous_point = route_points[i - 1];
+      const auto& previous_point = route_points[i - 1].first;
       cur_time += (route_point.distance_from_start_route - previous_point.distance_from_start_route) / cur_speed;
     }
     result.push_back(RoutePointWithForecast{
@@ -136,86 +547,600 @@ std::vector<MarineRouteScanner::RoutePointWithForecast> MarineRouteScanner::GetR
   return result;
 }
 
-std::vector<entities::diagnostic::DiagnosticHazardPoint> MarineRouteScanner::GetForecastDiagnostic(
-  const std::vector<RoutePointWithForecast>& route, const time_t check_time
+helpers::HazardSamples MarineRouteScanner::GetForecastDiagnostic(
+  const RouteScannerInput& route_data,
+  const RouteInfo& route,
+  std::pmr::memory_resource* memory
 ) const {
-  std::vector<entities::diagnostic::DiagnosticHazardPoint> result;
+  std::pmr::vector<std::optional<helpers::HazardSample>> hazards(route.size(), memory);
 
-  for(const auto& route_point : route) {
-    const auto& nearest_forecast = route_point.closest_forecast;
+  common::ParallelFor(*thread_pool_, route.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const auto& route_point = route[i];
+      const auto& nearest_forecast = route_point.closest_forecast;
+
+      if (!nearest_forecast.has_value()) {
+        continue;
+      }
+
+      if (nearest_forecast->GetWaveHeight() > route_data.ShipPerformanceInfo.DangerHeight.value()) {
+        hazards[i] = helpers::HazardSample{
+          .location = route_point.closest_forecast->point,
+          .expected_time = route_point.expected_time,
+          .value = nearest_forecast->GetWaveHeight(),
+        };
+      }
+    }
+  });
+
+  helpers::HazardSamples result(memory);
+  for (auto& hazard : hazards) {
+    if (hazard.has_value()) {
+      result.push_back(std::move(hazard.value()));
+    }
+  }
+  return result;
+}
+
+std::vector<std::shared_ptr<const entities::DepthProfile>> MarineRouteScanner::GetDepthProfiles(
+  const std::vector<std::shared_ptr<entities::Route>>& routes,
+  double half_width
+) {
+  std::lock_guard lock(depth_profile_mutex_);
+  const auto depth_version = depth_mask_provider_->GetVersion();
+  if (depth_profiles_.depth_version != depth_version ||
+      depth_profiles_.segment_tiles.size() + depth_profiles_.route_profiles.size() > kMaxCachedSegments) {
+    depth_profiles_ = DepthProfileCache{
+      .depth_version = depth_version,
+      .segment_tiles = {},
+      .route_profiles = {},
+    };
+  }
+  auto& segment_tiles = depth_profiles_.segment_tiles;
+  auto& route_profiles = depth_profiles_.route_profiles;
 
-    if (!nearest_forecast.has_value()) {
+  // segments shared by routes or left unchanged by a route edit are queried once
+  std::vector<uint64_t> route_keys(routes.size());
+  std::vector<common::Polygon> polygons;
+  std::vector<std::pair<uint64_t, size_t>> fetch_segments;  // segment key and its tile count
+  std::unordered_set<uint64_t> fetch_keys;
+  for (size_t i = 0; i < routes.size(); ++i) {
+    common::Hasher route_hasher;
+    for (const auto& segment : routes[i]->GetSegments()) {
+      route_hasher.Add(segment.segment.Start).Add(segment.segment.End);
+    }
+    route_keys[i] = route_hasher.Add(half_width).Get();
+    if (route_profiles.find(route_keys[i]) != route_profiles.end()) {
       continue;
     }
+    for (const auto& segment : routes[i]->GetSegments()) {
+      const auto key = common::Hasher().Add(segment.segment.Start).Add(segment.segment.End).Add(half_width).Get();
+      if (segment_tiles.find(key) != segment_tiles.end() || !fetch_keys.insert(key).second) {
+        continue;
+      }
+      const auto tiles = helpers::MakeCorridorTiles(segment.segment, half_width, kCorridorTileMeters);
+      for (const auto& tile : tiles) {
+        polygons.push_back(tile.polygon);
+      }
+      fetch_segments.emplace_back(key, tiles.size());
+    }
+  }
+
+  if (!polygons.empty()) {
+    auto points = db_client_->SelectShallowestDepthPointsInTiles(polygons);
+    auto it = points.begin();
+    for (const auto& [key, tile_count] : fetch_segments) {
+      segment_tiles.emplace(key, std::vector<std::optional<entities::DepthPoint>>(it, it + tile_count));
+      it += tile_count;
+    }
+  }
 
-    if (nearest_forecast->GetWaveHeight() > route_data_.ShipPerformanceInfo.DangerHeight.value()) {
-      result.push_back(entities::diagnostic::MakeHighWavesHazardPoint(
-        route_point.closest_forecast->point,
-        check_time,
-        route_point.expected_time,
-        nearest_forecast->GetWaveHeight())
-      );
+  std::vector<std::shared_ptr<const entities::DepthProfile>> result(routes.size());
+  for (size_t i = 0; i < routes.size(); ++i) {
+    auto& profile = route_profiles[route_keys[i]];
+    if (profile == nullptr) {
+      std::vector<entities::DepthProfile::Tile> tiles;
+      const auto& segments = routes[i]->GetSegments();
+      for (size_t segment_id = 0; segment_id < segments.size(); ++segment_id) {
+        const auto& segment = segments[segment_id].segment;
+        const auto key = common::Hasher().Add(segment.Start).Add(segment.End).Add(half_width).Get();
+        for (const auto& point : segment_tiles.at(key)) {
+          tiles.push_back(entities::DepthProfile::Tile{segment_id, point});
+        }
+      }
+      profile = std::make_shared<const entities::DepthProfile>(std::move(tiles));
     }
+    result[i] = profile;
   }
   return result;
 }
 
-std::vector<entities::diagnostic::DiagnosticHazardPoint> MarineRouteScanner::GetDepthDiagnostic(
-  const std::vector<RoutePointWithForecast>& route,
+std::vector<std::shared_ptr<const entities::DepthProfile>> MarineRouteScanner::GetNestedDepthProfiles(
+  const entities::Route& route,
+  const std::vector<double>& half_widths,
+  double max_draft
+) {
+  const double max_half_width = *std::max_element(half_widths.begin(), half_widths.end());
+
+  // tiles of a narrower corridor lie inside the tiles of the widest one with the same index
+  std::vector<std::vector<helpers::CorridorTile>> segment_tiles;
+  std::vector<common::Polygon> polygons;
+  for (const auto& segment : route.GetSegments()) {
+    segment_tiles.push_back(helpers::MakeCorridorTiles(segment.segment, max_half_width, kCorridorTileMeters));
+    for (const auto& tile : segment_tiles.back()) {
+      polygons.push_back(tile.polygon);
+    }
+  }
+  const auto tile_points = db_client_->SelectShallowDepthPointsInTiles(polygons, max_draft);
+
+  std::vector<std::shared_ptr<const entities::DepthProfile>> result;
+  for (const double half_width : half_widths) {
+    std::vector<entities::DepthProfile::Tile> tiles;
+    size_t tile_id = 0;
+    for (size_t segment_id = 0; segment_id < segment_tiles.size(); ++segment_id) {
+      const auto narrow_tiles =
+          helpers::MakeCorridorTiles(route.GetSegments()[segment_id].segment, half_width, kCorridorTileMeters);
+      for (const auto& narrow_tile : narrow_tiles) {
+        std::optional<entities::DepthPoint> shallowest_point;
+        for (const auto& point : tile_points[tile_id]) {
+          if ((!shallowest_point.has_value() || point.Depth > shallowest_point->Depth) &&
+              common::IsInsidePolygon(point.Point, narrow_tile.polygon)) {
+            shallowest_point = point;
+          }
+        }
+        tiles.push_back(entities::DepthProfile::Tile{segment_id, shallowest_point});
+        ++tile_id;
+      }
+    }
+    result.push_back(std::make_shared<const entities::DepthProfile>(std::move(tiles)));
+  }
+  return result;
+}
+
+std::optional<entities::diagnostic::DiagnosticHazardPoint> MarineRouteScanner::GetLimitingWaveHazard(
+  const RouteScannerInput& route_data,
+  const RouteInfo& route,
   const time_t check_time
 ) const {
-  std::vector<common::Polygon> polygons;
-  std::vector<RoutePointWithForecast> start_points;
+  const RoutePointWithForecast* limiting_point = nullptr;
+  for (const auto& route_point : route) {
+    const auto& nearest_forecast = route_point.closest_forecast;
+    if (!nearest_forecast.has_value() ||
+        nearest_forecast->GetWaveHeight() <= route_data.ShipPerformanceInfo.DangerHeight.value()) {
+      continue;
+    }
+    if (limiting_point == nullptr ||
+        nearest_forecast->GetWaveHeight() > limiting_point->closest_forecast->GetWaveHeight()) {
+      limiting_point = &route_point;
+    }
+  }
+
+  if (limiting_point == nullptr) {
+    return std::nullopt;
+  }
+  return entities::diagnostic::MakeHighWavesHazardPoint(
+    limiting_point->closest_forecast->point,
+    check_time,
+    limiting_point->expected_time,
+    limiting_point->closest_forecast->GetWaveHeight());
+}
+
+std::pmr::vector<helpers::HazardSamples> MarineRouteScanner::GetDepthDiagnostics(
+  const std::vector<RouteScan>& scans,
+  std::pmr::memory_resource* memory
+) {
+  std::pmr::vector<helpers::HazardSamples> result(scans.size(), memory);
+  if (scans.empty()) {
+    return result;
+  }
+  // the corridor follows the nominal speed, so the profiles do not depend on the forecasts
+  const auto& ship = scans.front().route_data.ShipPerformanceInfo;
+  const double half_width = helpers::GetCorridorHalfWidth(common::CalculateSteeringAngle(ship.Speed.value()));
+  std::vector<std::shared_ptr<entities::Route>> routes;
+  for (const auto& scan : scans) {
+    routes.push_back(scan.route_data.Route);
+  }
+  const auto profiles = GetDepthProfiles(routes, half_width);
+
+  for (size_t scan_id = 0; scan_id < scans.size(); ++scan_id) {
+    const auto& route_info = scans[scan_id].route_info;
+    const auto& segments = routes[scan_id]->GetSegments();
+    // the first scanned point of every segment, a monitoring scan starts in the middle of the route
+    std::pmr::vector<const RoutePointWithForecast*> segment_starts(segments.size(), nullptr, memory);
+    for (size_t i = 0; i < route_info.size(); ++i) {
+      if (i == 0 || route_info[i - 1].route_point.segment_id != route_info[i].route_point.segment_id) {
+        segment_starts[route_info[i].route_point.segment_id] = &route_info[i];
+      }
+    }
 
-  for(size_t i = 0; i < route.size(); ++i) {
-    const auto& point = route[i];
-    const auto segment_id = point.route_point.segment_id;
-    if (i == 0 || route[i - 1].route_point.segment_id != segment_id) {
-      const auto& segment = route_data_.Route->GetSegments()[segment_id];
-      const auto alpha = common::CalculateSteeringAngle(point.speed);
-      const auto [poly1, poly2] = MakeDepthCheckPolygon(segment.segment, alpha);
-      polygons.push_back(poly1);
-      polygons.push_back(poly2);
-      start_points.push_back(point);
-      start_points.push_back(point);
+    const auto& tiles = profiles[scan_id]->GetTiles();
+    for (const size_t tile_id : profiles[scan_id]->FindShallowTiles(ship.ShipDraft.value())) {
+      const auto& tile = tiles[tile_id];
+      const auto* start_point = segment_starts[tile.segment_id];
+      if (start_point == nullptr) {
+        continue;
+      }
+      const auto& depth_point = tile.shallowest_point.value();
+      const auto& segment = segments[tile.segment_id].segment;
+      // a monitoring scan starts in the middle of the first segment
+      if (start_point == &route_info.front() &&
+          common::DotProduct(segment.End - segment.Start, depth_point.Point - start_point->route_point.point) < 0) {
+        continue;
+      }
+      const time_t expected_time = start_point->expected_time + common::GetHaversineDistance(start_point->route_point.point, depth_point.Point) / start_point->speed;
+      result[scan_id].push_back(helpers::HazardSample{depth_point.Point, expected_time, depth_point.Depth});
     }
   }
+  return result;
+}
+
+std::string MarineRouteScanner::GetScanResultKey(const RouteScannerInput& route_data) const {
+  return MakeScanResultKey(route_data, scan_cache_->forecast_id, scan_cache_->depth_version);
+}
+
+std::optional<MarineRouteScanner::Diagnostic> MarineRouteScanner::LoadScanResult(const std::string& scan_key) {
+  try {
+    return db_client_->SelectScanResult(scan_key);
+  } catch (std::exception& ex) {
+    wxLogWarning(_T("Failed to load scan result with reason: %s"), ex.what());
+    return std::nullopt;
+  }
+}
+
+void MarineRouteScanner::StoreScanResult(const std::string& scan_key, const Diagnostic& diagnostic) {
+  try {
+    db_client_->InsertScanResult(scan_key, diagnostic);
+  } catch (std::exception& ex) {
+    wxLogWarning(_T("Failed to store scan result with reason: %s"), ex.what());
+  }
+}
+
+MarineRouteScanner::Diagnostic MarineRouteScanner::DoCrossDetect(const RouteScannerInput& route_data,
+                                                                 const HazardsCallback& on_hazards) {
+  // after a route edit only changed segments are queried, the shifted tail is evaluated from the cache
+  std::lock_guard lock(scan_mutex_);
+  ValidateScanCache(route_data);
+  const auto scan_key = GetScanResultKey(route_data);
+  if (auto cached = LoadScanResult(scan_key)) {
+    if (on_hazards) {
+      auto points = cached->hazard_points;
+      std::stable_sort(points.begin(), points.end(),
+        [](const entities::diagnostic::DiagnosticHazardPoint& lhs, const entities::diagnostic::DiagnosticHazardPoint& rhs) {
+          return lhs.GetExpectedTime() < rhs.GetExpectedTime();
+        });
+      on_hazards(std::move(points));
+    }
+    return std::move(cached.value());
+  }
+
+  // intermediates of the detection are released at once when it ends
+  common::Arena arena;
+  const double draft = route_data.ShipPerformanceInfo.ShipDraft.value();
+  if (!on_hazards) {
+    FetchSegmentForecasts({route_data.Route}, route_data.DepartTime, draft, scan_cache_->segment_forecasts);
+    auto route_info = GetRouteInfo(route_data, ScanStart{0, route_data.DepartTime}, scan_cache_->segment_forecasts, &arena);
+    auto diagnostic = MakeDiagnostic(route_data, std::move(route_info), &arena);
+    LogArenaStats("Cross detect", arena);
+    StoreScanResult(scan_key, diagnostic);
+    return diagnostic;
+  }
 
-  const auto hazard_triangle_points = db_client_->SelectHazardDepthPointsInAngle(polygons, route_data_.ShipPerformanceInfo.ShipDraft.value());
-  std::vector<entities::diagnostic::DiagnosticHazardPoint> result;
-  for(size_t i = 0; i < hazard_triangle_points.size(); ++i) {
-    const auto& start_point = start_points[i];
-    const auto& triangel_points = hazard_triangle_points[i];
-    for(const  auto& depth_point : triangel_points) {
-      const time_t expected_time = start_point.expected_time + common::GetHaversineDistance(start_point.route_point.point, depth_point.Point) / start_point.speed;
-      result.push_back(entities::diagnostic::MakeDepthHazardPoint(depth_point.Point, check_time, expected_time, depth_point.Depth));
+  // Parts of the route are queried and checked one by one, so the first hazards are shown before the rest
+  // of the route is queried. Every part starts at the expected time of the previous part end.
+  const time_t check_time = common::GetCurrentTime();
+  const auto& segments = route_data.Route->GetSegments();
+  RouteHazards hazards{helpers::HazardSamples(&arena), helpers::HazardSamples(&arena)};
+  time_t part_start_time = route_data.DepartTime;
+  for (size_t first_segment = 0; first_segment < segments.size();) {
+    size_t last_segment = first_segment;
+    double part_length = 0;
+    while (last_segment < segments.size() && (last_segment == first_segment || part_length < kStreamPartMeters)) {
+      part_length += segments[last_segment++].length;
     }
+
+    auto part_data = route_data;
+    part_data.Route = std::make_shared<entities::Route>(route_data.Route->GetPart(first_segment, last_segment));
+    FetchSegmentForecasts({part_data.Route}, route_data.DepartTime, draft, scan_cache_->segment_forecasts);
+    std::vector<RouteScan> part_scans;
+    part_scans.push_back(RouteScan{
+      part_data, GetRouteInfo(part_data, ScanStart{0, part_start_time}, scan_cache_->segment_forecasts, &arena)});
+    auto part_hazards = std::move(GetRouteHazards(part_scans, &arena).front());
+    auto part_points = MakeDiagnostic(part_hazards, check_time).hazard_points;
+    std::stable_sort(part_points.begin(), part_points.end(),
+      [](const entities::diagnostic::DiagnosticHazardPoint& lhs, const entities::diagnostic::DiagnosticHazardPoint& rhs) {
+        return lhs.GetExpectedTime() < rhs.GetExpectedTime();
+      });
+    on_hazards(std::move(part_points));
+
+    std::move(part_hazards.depth.begin(), part_hazards.depth.end(), std::back_inserter(hazards.depth));
+    std::move(part_hazards.waves.begin(), part_hazards.waves.end(), std::back_inserter(hazards.waves));
+    const auto& part_end = part_scans.front().route_info.back();
+    part_start_time = part_end.expected_time + static_cast<time_t>(
+      (part_data.Route->GetDistance() - part_end.route_point.distance_from_start_route) / part_end.speed);
+    first_segment = last_segment;
   }
+  auto diagnostic = MakeDiagnostic(hazards, check_time);
+  LogArenaStats("Cross detect", arena);
+  StoreScanResult(scan_key, diagnostic);
+  return diagnostic;
+}
 
+std::vector<std::optional<MarineRouteScanner::Diagnostic>> MarineRouteScanner::CrossDetectFleet(
+    const std::vector<std::shared_ptr<entities::Route>>& routes,
+    const entities::ShipPerformanceInfo& ship, time_t depart_time) {
+  std::vector<std::optional<Diagnostic>> result(routes.size());
+  common::Arena arena;
+  std::vector<RouteScan> scans;
+  std::vector<size_t> scan_routes;
+  for (size_t i = 0; i < routes.size(); ++i) {
+    if (routes[i] != nullptr && !routes[i]->GetSegments().empty()) {
+      scans.push_back(RouteScan{RouteScannerInput{routes[i], ship, depart_time}, RouteInfo(&arena)});
+      scan_routes.push_back(i);
+    }
+  }
+  if (scans.empty()) {
+    return result;
+  }
+
+  try {
+    std::lock_guard lock(scan_mutex_);
+    ValidateScanCache(scans.front().route_data);
+
+    // only routes without persisted results are scanned
+    std::vector<std::string> scan_keys;
+    size_t scan_count = 0;
+    for (size_t i = 0; i < scans.size(); ++i) {
+      auto scan_key = GetScanResultKey(scans[i].route_data);
+      if (auto cached = LoadScanResult(scan_key)) {
+        result[scan_routes[i]] = std::move(cached);
+        continue;
+      }
+      if (scan_count != i) {
+        scans[scan_count] = std::move(scans[i]);
+        scan_routes[scan_count] = scan_routes[i];
+      }
+      scan_keys.push_back(std::move(scan_key));
+      ++scan_count;
+    }
+    scans.resize(scan_count);
+    scan_routes.resize(scan_count);
+    if (scans.empty()) {
+      return result;
+    }
+
+    std::vector<std::shared_ptr<entities::Route>> scan_route_ptrs;
+    for (const auto& scan : scans) {
+      scan_route_ptrs.push_back(scan.route_data.Route);
+    }
+    FetchSegmentForecasts(scan_route_ptrs, depart_time, ship.ShipDraft.value(), scan_cache_->segment_forecasts);
+
+    // routes are propagated concurrently, the forecasts are only read from the cache
+    const auto& segment_forecasts = scan_cache_->segment_forecasts;
+    common::ParallelFor(*thread_pool_, scans.size(), [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        scans[i].route_info = GetRouteInfo(scans[i].route_data, ScanStart{0, depart_time}, segment_forecasts, &arena);
+      }
+    });
+
+    auto diagnostics = MakeDiagnostics(scans, &arena);
+    LogArenaStats("Cross detect fleet", arena);
+    for (size_t i = 0; i < scans.size(); ++i) {
+      StoreScanResult(scan_keys[i], diagnostics[i]);
+      result[scan_routes[i]] = std::move(diagnostics[i]);
+    }
+  } catch (std::exception& ex) {
+    wxLogError(_T("Failed to check the routes with reason: %s"), ex.what());
+  }
   return result;
 }
 
-entities::diagnostic::RouteValidateDiagnostic MarineRouteScanner::DoCrossDetect() const {
-  const auto route_info = GetRouteInfo();
+void MarineRouteScanner::CrossDetectFleetAsync(std::vector<std::shared_ptr<entities::Route>> routes,
+                                               entities::ShipPerformanceInfo ship, time_t depart_time,
+                                               FleetDetectCallback on_finished) {
+  detect_worker_.Submit([this, routes = std::move(routes), ship, depart_time, on_finished = std::move(on_finished)] {
+    on_finished(CrossDetectFleet(routes, ship, depart_time));
+  });
+}
+
+std::vector<entities::diagnostic::DepartureDiagnostic> MarineRouteScanner::ScanDepartureWindow(
+    const RouteScannerInput& route_data, time_t from, time_t to, time_t step) {
+  const size_t kMaxDepartureCount = 1000;
+
+  if (step <= 0 || to < from) {
+    throw std::runtime_error("invalid departure window");
+  }
+  const size_t departure_count = static_cast<size_t>((to - from) / step) + 1;
+  if (departure_count > kMaxDepartureCount) {
+    throw std::runtime_error("too many departures in window");
+  }
+  if (route_data.Route == nullptr || route_data.Route->GetSegments().empty()) {
+    throw std::runtime_error("empty route");
+  }
+
+  // the forecast slice of the route corridor is queried once for the whole window, waves slow the ship down,
+  // so the passage at full speed is taken with a margin
+  const auto passage_time = static_cast<time_t>(
+      kPassageTimeMargin * route_data.Route->GetDistance() / route_data.ShipPerformanceInfo.Speed.value());
+  SegmentForecasts forecasts;
+  FetchSegmentForecasts({route_data.Route}, from, route_data.ShipPerformanceInfo.ShipDraft.value(), forecasts,
+                        to + passage_time);
+  std::optional<time_t> forecast_end;
+  for (const auto& [key, segment_samples] : forecasts) {
+    for (const auto& [forecast, distance, sample_id] : segment_samples.forecasts) {
+      forecast_end = std::max(forecast_end.value_or(forecast.end_at), forecast.end_at);
+    }
+  }
+
+  // samples and their forecasts do not depend on the departure
+  common::Arena samples_arena;
+  const auto samples = GetRouteSamples(*route_data.Route, forecasts, &samples_arena);
+
   const time_t check_time = common::GetCurrentTime();
-  const auto diagnostic_forecast = GetForecastDiagnostic(route_info, check_time);
-  const auto diagnostic_depth = GetDepthDiagnostic(route_info, check_time);
+  std::vector<entities::diagnostic::DepartureDiagnostic> result(departure_count);
+  common::ParallelFor(*thread_pool_, departure_count, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const time_t depart_time = from + static_cast<time_t>(i) * step;
+      // an arena per departure, so propagations of the window are not kept till its end
+      common::Arena arena;
+      const auto route_info = PropagateRoute(route_data, ScanStart{0, depart_time}, samples, &arena);
+      result[i] = entities::diagnostic::DepartureDiagnostic{
+        .depart_time = depart_time,
+        .limiting_hazard = GetLimitingWaveHazard(route_data, route_info, check_time),
+        .forecast_covers_passage = forecast_end.has_value() && !route_info.empty() &&
+                                   route_info.back().expected_time <= forecast_end.value(),
+      };
+    }
+  });
+  return result;
+}
+
+void MarineRouteScanner::ScanDepartureWindowAsync(RouteScannerInput route_data, time_t from, time_t to, time_t step,
+                                                  DepartureWindowCallback on_finished) {
+  detect_worker_.Submit([this, route_data = std::move(route_data), from, to, step, on_finished = std::move(on_finished)] {
+    std::optional<std::vector<entities::diagnostic::DepartureDiagnostic>> departures;
+    try {
+      departures = ScanDepartureWindow(route_data, from, to, step);
+    } catch (std::exception& ex) {
+      wxLogError(_T("Failed to scan the departure window with reason: %s"), ex.what());
+    }
+    on_finished(std::move(departures));
+  });
+}
+
+entities::diagnostic::FeasibilityMatrix MarineRouteScanner::SweepShipParameters(
+    const RouteScannerInput& route_data, const ShipParametersGrid& grid) {
+  const size_t kMaxCombinationCount = 100000;
+
+  const size_t combination_count = grid.drafts.size() * grid.speeds.size() * grid.danger_heights.size();
+  if (combination_count == 0 || combination_count > kMaxCombinationCount) {
+    throw std::runtime_error("invalid ship parameters grid");
+  }
+  if (route_data.Route == nullptr || route_data.Route->GetSegments().empty()) {
+    throw std::runtime_error("empty route");
+  }
 
-  if (diagnostic_forecast.empty() && diagnostic_depth.empty()) { 
+  // samples near dangers for the deepest draft are the densest
+  const double max_draft = *std::max_element(grid.drafts.begin(), grid.drafts.end());
+  SegmentForecasts forecasts;
+  FetchSegmentForecasts({route_data.Route}, route_data.DepartTime, max_draft, forecasts);
+
+  // a depth profile per speed checks every draft, depths are queried once for the widest corridor
+  std::vector<double> half_widths;
+  for (const double speed : grid.speeds) {
+    half_widths.push_back(helpers::GetCorridorHalfWidth(common::CalculateSteeringAngle(speed)));
+  }
+  const auto speed_profiles = GetNestedDepthProfiles(*route_data.Route, half_widths, max_draft);
+
+  // only the speed changes the route propagation, samples are shared by all speeds
+  common::Arena arena;
+  const auto samples = GetRouteSamples(*route_data.Route, forecasts, &arena);
+  std::pmr::vector<RouteInfo> speed_route_infos(grid.speeds.size(), &arena);
+  common::ParallelFor(*thread_pool_, grid.speeds.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      auto speed_route_data = route_data;
+      speed_route_data.ShipPerformanceInfo.Speed = grid.speeds[i];
+      speed_route_infos[i] = PropagateRoute(speed_route_data, ScanStart{0, route_data.DepartTime}, samples, &arena);
+    }
+  });
+
+  entities::diagnostic::FeasibilityMatrix result{
+    .drafts = grid.drafts,
+    .speeds = grid.speeds,
+    .danger_heights = grid.danger_heights,
+    .cells = std::vector<entities::diagnostic::FeasibilityMatrix::Cell>(combination_count),
+  };
+  const size_t danger_height_count = grid.danger_heights.size();
+  common::ParallelFor(*thread_pool_, grid.drafts.size() * grid.speeds.size(), [&](size_t begin, size_t end) {
+    for (size_t id = begin; id < end; ++id) {
+      const double draft = grid.drafts[id / grid.speeds.size()];
+      const auto& route_info = speed_route_infos[id % grid.speeds.size()];
+      const size_t depth_hazard_count = speed_profiles[id % grid.speeds.size()]->FindShallowTiles(draft).size();
+
+      for (size_t k = 0; k < danger_height_count; ++k) {
+        size_t wave_hazard_count = 0;
+        for (const auto& point : route_info) {
+          if (point.closest_forecast.has_value() && point.closest_forecast->GetWaveHeight() > grid.danger_heights[k]) {
+            ++wave_hazard_count;
+          }
+        }
+        result.cells[id * danger_height_count + k] = {depth_hazard_count, wave_hazard_count};
+      }
+    }
+  });
+  return result;
+}
+
+void MarineRouteScanner::SweepShipParametersAsync(RouteScannerInput route_data, ShipParametersGrid grid,
+                                                  SweepCallback on_finished) {
+  detect_worker_.Submit([this, route_data = std::move(route_data), grid = std::move(grid), on_finished = std::move(on_finished)] {
+    std::optional<entities::diagnostic::FeasibilityMatrix> matrix;
+    try {
+      matrix = SweepShipParameters(route_data, grid);
+    } catch (std::exception& ex) {
+      wxLogError(_T("Failed to sweep ship parameters with reason: %s"), ex.what());
+    }
+    on_finished(std::move(matrix));
+  });
+}
+
+MarineRouteScanner::Diagnostic MarineRouteScanner::MakeDiagnostic(
+    const RouteScannerInput& route_data,
+    RouteInfo route_info,
+    std::pmr::memory_resource* memory) {
+  // moved, a copied route info would be allocated from the default memory
+  std::vector<RouteScan> scans;
+  scans.push_back(RouteScan{route_data, std::move(route_info)});
+  return MakeDiagnostics(scans, memory).front();
+}
+
+std::pmr::vector<MarineRouteScanner::RouteHazards> MarineRouteScanner::GetRouteHazards(
+    const std::vector<RouteScan>& scans,
+    std::pmr::memory_resource* memory) {
+  auto depth_hazards = GetDepthDiagnostics(scans, memory);
+
+  std::pmr::vector<RouteHazards> result(memory);
+  result.reserve(scans.size());
+  for (size_t i = 0; i < scans.size(); ++i) {
+    result.push_back(RouteHazards{
+      .depth = std::move(depth_hazards[i]),
+      .waves = GetForecastDiagnostic(scans[i].route_data, scans[i].route_info, memory),
+    });
+  }
+  return result;
+}
+
+MarineRouteScanner::Diagnostic MarineRouteScanner::MakeDiagnostic(const RouteHazards& hazards, time_t check_time) {
+  if (hazards.depth.empty() && hazards.waves.empty()) {
     return entities::diagnostic::RouteValidateDiagnostic{
       .result = entities::diagnostic::RouteValidateDiagnostic::DiagnosticResultType::kOk,
       .hazard_points = {}
     };
   }
 
-  auto hazard_points = FilterDiagnosticPoints(diagnostic_depth, 10000);
-  const auto filtered_diagnostic_forecast = FilterDiagnosticPoints(diagnostic_forecast, 10000);
-  hazard_points.insert(hazard_points.end(), filtered_diagnostic_forecast.begin(), filtered_diagnostic_forecast.end());
-
+  std::vector<entities::diagnostic::DiagnosticHazardPoint> hazard_points;
+  for (const auto& cluster : helpers::ClusterHazards(hazards.depth, kHazardClusterCellMeters)) {
+    hazard_points.push_back(entities::diagnostic::MakeDepthHazardPoint(
+      cluster.location, check_time, cluster.earliest_time, cluster.worst_value, cluster.count, cluster.latest_time));
+  }
+  for (const auto& cluster : helpers::ClusterHazards(hazards.waves, kHazardClusterCellMeters)) {
+    hazard_points.push_back(entities::diagnostic::MakeHighWavesHazardPoint(
+      cluster.location, check_time, cluster.earliest_time, cluster.worst_value, cluster.count, cluster.latest_time));
+  }
   return entities::diagnostic::RouteValidateDiagnostic{
     .result = entities::diagnostic::RouteValidateDiagnostic::DiagnosticResultType::kWarning,
     .hazard_points = hazard_points
   };
 }
 
+std::vector<MarineRouteScanner::Diagnostic> MarineRouteScanner::MakeDiagnostics(
+    const std::vector<RouteScan>& scans,
+    std::pmr::memory_resource* memory) {
+  const time_t check_time = common::GetCurrentTime();
+  std::vector<Diagnostic> result;
+  for (const auto& hazards : GetRouteHazards(scans, memory)) {
+    result.push_back(MakeDiagnostic(hazards, check_time));
+  }
+  return result;
+}
+
 }  // namespace marine_navi::cases
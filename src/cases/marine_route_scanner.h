@@ -1,17 +1,26 @@
 #pragma once
 
 
+#include <functional>
+#include <memory_resource>
 #include <mutex>
 #include <optional>
+#include <unordered_map>
 
 #include <wx/wx.h>
 
 #include <ocpn_plugin.h>
 
+#include "cases/depth_mask_provider.h"
+#include "cases/helpers/forecast_accessor.h"
+#include "cases/helpers/hazard_clustering.h"
 #include "clients/db_client.h"
+#include "common/arena.h"
 #include "common/geom.h"
+#include "common/thread_pool.h"
 #include "common/utils.h"
 #include "entities/depth_grid.h"
+#include "entities/depth_profile.h"
 #include "entities/diagnostic/diagnostic.h"
 #include "entities/diagnostic/diagnostic_hazard_point.h"
 #include "entities/route.h"
@@ -26,20 +35,91 @@ struct RouteScannerInput {
   time_t DepartTime;
 };
 
+// Immutable state of the scanner, a new version is published on every change
+struct RouteScannerSnapshot {
+  uint64_t version;
+  RouteScannerInput route_data;
+  bool show;
+  // nullptr until detection for the route succeeds
+  std::shared_ptr<const entities::diagnostic::RouteValidateDiagnostic> diagnostic;
+  // the detection which made the diagnostic
+  uint64_t detection_id;
+  // true while the route is scanned, hazards of the scanned part are only appended until the detection completes
+  bool partial;
+};
+
+// Values of ship parameters to sweep, every combination is checked
+struct ShipParametersGrid {
+  std::vector<double> drafts;
+  std::vector<double> speeds;
+  std::vector<double> danger_heights;
+};
+
 class MarineRouteScanner {
   using Point = common::Point;
 
 public:
-  MarineRouteScanner(std::shared_ptr<clients::DbClient> dbClient);
+  using Diagnostic = entities::diagnostic::RouteValidateDiagnostic;
+  // called from the detection thread
+  using DetectCallback = std::function<void(std::optional<Diagnostic>)>;
+  // called from the detection thread with hazards of the next part of the route, in route order
+  using HazardsCallback = std::function<void(std::vector<entities::diagnostic::DiagnosticHazardPoint>)>;
+  using FleetDetectCallback = std::function<void(std::vector<std::optional<Diagnostic>>)>;
+  using DepartureWindowCallback =
+      std::function<void(std::optional<std::vector<entities::diagnostic::DepartureDiagnostic>>)>;
+  using SweepCallback = std::function<void(std::optional<entities::diagnostic::FeasibilityMatrix>)>;
+
+  MarineRouteScanner(std::shared_ptr<clients::DbClient> dbClient,
+                     std::shared_ptr<DepthMaskProvider> depth_mask_provider,
+                     std::shared_ptr<common::ThreadPool> thread_pool);
   void SetPathData(const RouteScannerInput& pathData);
-  const RouteScannerInput& GetPathData();
   void SetShow(bool show);
-  bool IsShow();
-  void CrossDetect();
+  // Detects hazards for the current path data in background, detections run one by one. With on_hazards
+  // the route is scanned part by part, hazards of every part are published to the snapshot as they are found,
+  // and on_finished gets hazards of the whole route clustered together, or nullopt if the detection failed.
+  void CrossDetectAsync(DetectCallback on_finished, HazardsCallback on_hazards = nullptr);
+  // Detects hazards of all routes for one ship, every segment shared by the routes is queried once.
+  // Results are in the order of routes and are not published to the snapshot.
+  std::vector<std::optional<Diagnostic>> CrossDetectFleet(
+      const std::vector<std::shared_ptr<entities::Route>>& routes,
+      const entities::ShipPerformanceInfo& ship, time_t depart_time);
+  void CrossDetectFleetAsync(std::vector<std::shared_ptr<entities::Route>> routes,
+                             entities::ShipPerformanceInfo ship, time_t depart_time,
+                             FleetDetectCallback on_finished);
+  // Checks waves along the route for departures every step from `from` to `to`, forecasts of the
+  // route are queried once and the departures are propagated concurrently. DepartTime is ignored.
+  // Departures arriving after the forecasts end are unknown unless a hazard is found before.
+  std::vector<entities::diagnostic::DepartureDiagnostic> ScanDepartureWindow(
+      const RouteScannerInput& route_data, time_t from, time_t to, time_t step);
+  // on_finished gets std::nullopt if the scan failed
+  void ScanDepartureWindowAsync(RouteScannerInput route_data, time_t from, time_t to, time_t step,
+                                DepartureWindowCallback on_finished);
+  // Checks the route for every combination of grid parameters, other ship parameters come from the
+  // route data. Forecasts are queried once, depths once per speed into draft independent profiles.
+  entities::diagnostic::FeasibilityMatrix SweepShipParameters(const RouteScannerInput& route_data,
+                                                              const ShipParametersGrid& grid);
+  void SweepShipParametersAsync(RouteScannerInput route_data, ShipParametersGrid grid, SweepCallback on_finished);
+
+  // Monitoring re-validates the rest of the current route from own ship positions,
+  // on_update is called from the detection thread with every published result
+  void StartMonitoring(DetectCallback on_update);
+  void StopMonitoring();
+  // Ignored unless monitoring, positions arriving while an update is running are coalesced
+  void UpdateOwnShipPosition(const Point& position, time_t fix_time);
 
-  std::optional<entities::diagnostic::RouteValidateDiagnostic> GetDiagnostic();
+  // Lock free, never waits for writers and detection
+  std::shared_ptr<const RouteScannerSnapshot> GetSnapshot() const;
 
 private:
+  using ClosestForecasts = std::vector<std::tuple<entities::ForecastPoint, double, int>>;
+  // samples of a segment and their closest forecasts
+  struct SegmentSamples {
+    std::vector<double> offsets;  // meters from the segment start, increasing from 0
+    ClosestForecasts forecasts;  // ids are indices of offsets
+  };
+  // samples of segments by segment hash
+  using SegmentForecasts = std::unordered_map<uint64_t, SegmentSamples>;
+
   struct RoutePointWithForecast {
     entities::RoutePoint route_point;
     std::optional<entities::ForecastPoint> closest_forecast;
@@ -47,22 +127,154 @@ private:
     double speed;
     time_t expected_time;
   };
-  std::vector<RoutePointWithForecast> GetRouteInfo() const;
+  // intermediates of a scan are allocated from its arena
+  using RouteInfo = std::pmr::vector<RoutePointWithForecast>;
+  // samples of a route in order and their forecasts, forecast ids are sample indices
+  struct RouteSamples {
+    std::pmr::vector<entities::RoutePoint> points;
+    helpers::ForecastAccessor forecasts;
+  };
+  // position the scan starts from, the route start at the departure time for a full check
+  struct ScanStart {
+    double distance;
+    time_t time;
+  };
+  // forecasts of the monitored route queried from a fix time to the end of the rest of the passage
+  struct MonitorForecasts {
+    time_t min_time;
+    time_t max_time;
+    SegmentForecasts segment_forecasts;
+  };
+  // query results by segment, reused by the scans of edited routes and by monitoring
+  struct ScanCache {
+    time_t depart_time;
+    double draft;
+    int64_t forecast_id;
+    std::optional<uint64_t> depth_version;
+    SegmentForecasts segment_forecasts;
+    std::optional<MonitorForecasts> monitor_forecasts;
+  };
+  // Shallowest points of corridor tiles by segment and half width hash, and profiles assembled from them
+  // by route and half width hash. Both do not depend on the draft, so they are kept until depths change
+  struct DepthProfileCache {
+    std::optional<uint64_t> depth_version;
+    std::unordered_map<uint64_t, std::vector<std::optional<entities::DepthPoint>>> segment_tiles;
+    std::unordered_map<uint64_t, std::shared_ptr<const entities::DepthProfile>> route_profiles;
+  };
+  struct RouteScan {
+    RouteScannerInput route_data;
+    RouteInfo route_info;
+  };
+  struct OwnShipFix {
+    Point position;
+    time_t time;
+  };
+  struct RouteHazards {
+    helpers::HazardSamples depth;
+    helpers::HazardSamples waves;
+  };
 
-  std::vector<entities::diagnostic::DiagnosticHazardPoint> GetForecastDiagnostic(
-    const std::vector<RoutePointWithForecast>& route,
-    const time_t check_time) const;
-  std::vector<entities::diagnostic::DiagnosticHazardPoint> GetDepthDiagnostic(
-    const std::vector<RoutePointWithForecast>& route,
+  // must be called under scan_mutex_, @return false if cached results of previous scans were dropped
+  bool ValidateScanCache(const RouteScannerInput& route_data);
+  // @return spacing in meters of the latest forecast grid, cached by forecast id
+  std::optional<double> GetForecastGridSpacing();
+  // samples the segments missing in cache adaptively and queries their forecasts, one query for all routes
+  // and one more for the midpoints where waves change fast. Samples get denser near dangers for the draft
+  // forecasts ending after max_forecast_time are not queried, 48 hours after the departure if not set
+  void FetchSegmentForecasts(const std::vector<std::shared_ptr<entities::Route>>& routes,
+                             time_t depart_time, double draft,
+                             SegmentForecasts& cache,
+                             std::optional<time_t> max_forecast_time = std::nullopt);
+  // @return samples of the route and the accessor of their forecasts, the segments must be fetched
+  RouteSamples GetRouteSamples(
+      const entities::Route& route, const SegmentForecasts& cache, std::pmr::memory_resource* memory) const;
+  // does not query, the route segments must be fetched
+  RouteInfo GetRouteInfo(const RouteScannerInput& route_data,
+                         const ScanStart& start,
+                         const SegmentForecasts& cache,
+                         std::pmr::memory_resource* memory) const;
+  // propagates the ship along samples of the route, scans of one route with other departures or speeds share them
+  RouteInfo PropagateRoute(const RouteScannerInput& route_data,
+                           const ScanStart& start,
+                           const RouteSamples& samples,
+                           std::pmr::memory_resource* memory) const;
+
+  helpers::HazardSamples GetForecastDiagnostic(
+    const RouteScannerInput& route_data,
+    const RouteInfo& route,
+    std::pmr::memory_resource* memory) const;
+  // @return depth profiles of the corridors of half_width meters around the routes, segments of all routes
+  // missing in the cache are queried at once. Tiles are not pruned by shoal polygons or the danger distance
+  // field, both are built for a draft and a profile serves every draft
+  std::vector<std::shared_ptr<const entities::DepthProfile>> GetDepthProfiles(
+    const std::vector<std::shared_ptr<entities::Route>>& routes, double half_width);
+  // @return depth profiles of the corridors of every half width, depth points shallower than max_draft are
+  // queried once for the widest corridor and the narrower ones take the points inside their tiles
+  std::vector<std::shared_ptr<const entities::DepthProfile>> GetNestedDepthProfiles(
+    const entities::Route& route, const std::vector<double>& half_widths, double max_draft);
+  // @return the highest waves above the danger height along the route, runs on the calling thread
+  std::optional<entities::diagnostic::DiagnosticHazardPoint> GetLimitingWaveHazard(
+    const RouteScannerInput& route_data,
+    const RouteInfo& route,
     const time_t check_time) const;
-  entities::diagnostic::RouteValidateDiagnostic DoCrossDetect() const;
+  // all scans are for the same ship, each segment is queried once
+  std::pmr::vector<helpers::HazardSamples> GetDepthDiagnostics(const std::vector<RouteScan>& scans,
+                                                              std::pmr::memory_resource* memory);
+  std::pmr::vector<RouteHazards> GetRouteHazards(const std::vector<RouteScan>& scans,
+                                                std::pmr::memory_resource* memory);
+  // clusters the hazards, the clusters are allocated from the memory of the hazards
+  static Diagnostic MakeDiagnostic(const RouteHazards& hazards, time_t check_time);
+  std::vector<Diagnostic> MakeDiagnostics(const std::vector<RouteScan>& scans, std::pmr::memory_resource* memory);
+  Diagnostic MakeDiagnostic(const RouteScannerInput& route_data, RouteInfo route_info,
+                            std::pmr::memory_resource* memory);
+  // must be called under scan_mutex_ after ValidateScanCache, @return the key of the persisted result
+  std::string GetScanResultKey(const RouteScannerInput& route_data) const;
+  // @return the persisted result of the same check, a failed read is logged and treated as missing
+  std::optional<Diagnostic> LoadScanResult(const std::string& scan_key);
+  // a failed write is logged only, the detection result stays valid
+  void StoreScanResult(const std::string& scan_key, const Diagnostic& diagnostic);
+  // streams hazards part by part when on_hazards is set, a persisted result is reused if the route, the ship,
+  // the departure and the loaded data are the same
+  Diagnostic DoCrossDetect(const RouteScannerInput& route_data, const HazardsCallback& on_hazards);
+  std::optional<Diagnostic> RunCrossDetect(const HazardsCallback& on_hazards);
+  // runs on the detection thread only, as everything it uses from the monitor_* members below
+  void RunMonitorUpdate();
+  // @return true if the monitoring result changed
+  bool UpdateMonitorDiagnostic(const RouteScannerInput& route_data, const OwnShipFix& fix);
+  // must be called under mutex_
+  void Publish(const std::function<void(RouteScannerSnapshot&)>& update);
 
 private:
-  std::mutex mutex_;
-  RouteScannerInput route_data_;
-  bool show_;
+  std::mutex mutex_;  // serializes writers only
+  // accessed with std::atomic_load and std::atomic_store
+  std::shared_ptr<const RouteScannerSnapshot> snapshot_;
   std::shared_ptr<clients::DbClient> db_client_;
-  std::optional<entities::diagnostic::RouteValidateDiagnostic> diagnostic_;
+  std::shared_ptr<DepthMaskProvider> depth_mask_provider_;
+  std::shared_ptr<common::ThreadPool> thread_pool_;
+  uint64_t detect_generation_;  // results of outdated detections are dropped
+
+  std::mutex monitor_mutex_;  // guards the callback, the pending fix and the queued flag
+  DetectCallback monitor_callback_;  // empty unless monitoring
+  std::optional<OwnShipFix> monitor_fix_;
+  bool monitor_update_queued_;
+
+  std::mutex forecast_spacing_mutex_;
+  // forecast id and its grid spacing
+  std::optional<std::pair<int64_t, std::optional<double>>> forecast_spacing_;
+
+  std::mutex scan_mutex_;  // serializes scans sharing scan_cache_
+  std::optional<ScanCache> scan_cache_;
+
+  std::mutex depth_profile_mutex_;
+  DepthProfileCache depth_profiles_;
+
+  // the route, expected times by distance along it and the result of the last monitoring scan
+  std::shared_ptr<entities::Route> monitor_route_;
+  std::vector<std::pair<double, time_t>> monitor_eta_;
+  std::optional<Diagnostic> monitor_diagnostic_;
+
+  // the last member, so queued detections finish before other members are destroyed
+  common::ThreadPool detect_worker_;
 };
 
 }  // namespace marine_navi::cases
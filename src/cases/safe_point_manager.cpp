@@ -1,16 +1,69 @@
 #include "safe_point_manager.h"
 
+#include "cases/helpers/forecast_accessor.h"
+#include "cases/helpers/route_helpers.h"
+
 namespace marine_navi::cases {
 
+namespace {
+
+constexpr double kForecastDistanceRad = 0.1;
+constexpr time_t kForecastLookBehind = 3*60*60;
+
+} // namespace
+
 SafePointManager::SafePointManager(std::shared_ptr<clients::DbClient> db_client): db_client_(db_client) {}
 
 
 void SafePointManager::Load(const entities::SafePoint& safe_point) {
     db_client_->InsertSafePoints({safe_point});
+
+    std::lock_guard lock(mutex_);
+    safety_field_key_ = std::nullopt;
+    safety_field_ = nullptr;
 }
 
 std::vector<entities::SafePoint> SafePointManager::GetSafePoints() {
     return db_client_->SelectSafePoints();
 }
 
+std::shared_ptr<const helpers::SafetyField> SafePointManager::GetSafetyField(
+    std::shared_ptr<const entities::FindRouteGrid> grid,
+    const entities::ShipPerformanceInfo& info,
+    time_t depart_time) {
+  std::lock_guard lock(mutex_);
+
+  const SafetyFieldKey key{
+    .forecast_id = db_client_->SelectLastForecastId(),
+    .grid = grid,
+    .info = info,
+    .depart_time = depart_time,
+  };
+  if (safety_field_key_.has_value() && safety_field_key_.value() == key) {
+    return safety_field_;
+  }
+
+  const auto safe_points = db_client_->SelectSafePoints();
+  if (safe_points.empty()) {
+    return nullptr;
+  }
+
+  const auto forecast_accessor = helpers::ForecastAccessor(db_client_->SelectClosestForecasts(
+      grid->GetPoints(), kForecastDistanceRad, depart_time - kForecastLookBehind));
+  std::vector<std::pair<int, time_t>> queries(grid->GetPoints().size());
+  for (size_t i = 0; i < queries.size(); ++i) {
+    queries[i] = {static_cast<int>(i), depart_time};
+  }
+  const auto forecasts = forecast_accessor.GetClosestForecasts(queries);
+  std::vector<double> speeds(forecasts.size());
+  for (size_t i = 0; i < speeds.size(); ++i) {
+    speeds[i] = helpers::GetSpeed(info, forecasts[i].has_value() ? forecasts[i]->GetWaveHeight() : 0);
+  }
+
+  safety_field_key_ = key;
+  safety_field_ = std::make_shared<const helpers::SafetyField>(helpers::BuildSafetyField(
+      grid, safe_points, [&speeds](int point_id) { return speeds[point_id]; }));
+  return safety_field_;
+}
+
 } // namespace marine_navi::cases
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
 
+#include "cases/helpers/safety_field.h"
 #include "clients/db_client.h"
+#include "entities/ship.h"
 
 namespace marine_navi::cases {
 
@@ -13,9 +16,32 @@ public:
   void Load(const entities::SafePoint& safe_point);
   std::vector<entities::SafePoint> GetSafePoints();
 
+  // @return time to safety field for the grid, cached until a new forecast or safe point is loaded.
+  // nullptr if there are no safe points
+  std::shared_ptr<const helpers::SafetyField> GetSafetyField(
+      std::shared_ptr<const entities::FindRouteGrid> grid,
+      const entities::ShipPerformanceInfo& info,
+      time_t depart_time);
+
+private:
+  struct SafetyFieldKey {
+    int64_t forecast_id;
+    std::shared_ptr<const entities::FindRouteGrid> grid;
+    entities::ShipPerformanceInfo info;
+    time_t depart_time;
+
+    bool operator==(const SafetyFieldKey& other) const {
+      return forecast_id == other.forecast_id && grid == other.grid &&
+             info == other.info && depart_time == other.depart_time;
+    }
+  };
+
 private:
   std::shared_ptr<clients::DbClient> db_client_;
 
+  std::mutex mutex_;
+  std::optional<SafetyFieldKey> safety_field_key_;
+  std::shared_ptr<const helpers::SafetyField> safety_field_;
 };
 
-}  // namespace marine_navi::cases
\ No newline at end of file
+}  // namespace marine_navi::cases
@@ -23,33 +23,63 @@ std::tuple<common::Polygon, common::Polygon> MakeDepthCheckPolygon(const common:
 
 TimeScorer::TimeScorer(const entities::ShipPerformanceInfo& info,
                        const std::vector<common::Point>& route_points,
-                       std::shared_ptr<clients::DbClient> db_client, time_t min_time):
+                       std::shared_ptr<clients::DbClient> db_client, time_t min_time,
+                       std::shared_ptr<const entities::ShallowMask> shallow_mask,
+                       std::shared_ptr<const entities::DangerDistanceField> distance_field):
   ship_performance_info_(info),
   route_points_(route_points),
   db_client_(db_client),
   min_time_(min_time),
   forecast_accessor_(db_client_->SelectClosestForecasts(route_points, kMinRad, min_time)),
-  danger_depth_points_(db_client_->SelectHazardDepthPoints(route_points, ship_performance_info_.DangerHeight.value(), kMinRad)) {
+  shallow_mask_(shallow_mask),
+  distance_field_(distance_field),
+  danger_depth_points_(shallow_mask_ != nullptr
+      ? std::vector<std::vector<entities::DepthPoint> >(route_points.size())
+      : db_client_->SelectHazardDepthPoints(route_points, ship_performance_info_.DangerHeight.value(), kMinRad)) {
 }
 
 int64_t TimeScorer::GetScore(int start_id, int end_id, time_t depart_time) {
   const auto start_point = route_points_.at(start_id);
   const auto end_point = route_points_.at(end_id);
 
-  const auto forecast = forecast_accessor_.GetClosestForecast(start_id, depart_time);
-  double wave_height = 0;
-  if (forecast.has_value()) {
-    wave_height = forecast->GetWaveHeight();
-  }
-  double speed = helpers::GetSpeed(ship_performance_info_, wave_height);
+  double speed = GetSpeed(start_id, depart_time);
   
-  if (danger_depth_points_[end_id].size() > 0) {
+  if (shallow_mask_ != nullptr) {
+    if (!IsEdgeSafe(start_point, end_point)) {
+      return kMaxScore;
+    }
+  } else if (danger_depth_points_[end_id].size() > 0) {
     return kMaxScore;
   }
 
   return common::GetHaversineDistance(start_point, end_point) / speed;
 }
 
+double TimeScorer::GetSpeed(int point_id, time_t time) const {
+  const auto forecast = forecast_accessor_.GetClosestForecast(point_id, time);
+  double wave_height = 0;
+  if (forecast.has_value()) {
+    wave_height = forecast->GetWaveHeight();
+  }
+  return helpers::GetSpeed(ship_performance_info_, wave_height);
+}
+
+bool TimeScorer::IsEdgeSafe(common::Point start_point, common::Point end_point) const {
+  if (distance_field_ != nullptr) {
+    const auto start_distance = distance_field_->GetDistance(start_point);
+    const auto end_distance = distance_field_->GetDistance(end_point);
+    if (start_distance.has_value() && end_distance.has_value()) {
+      // every point of the edge is closer than half of its length to one of the ends
+      const double slack = 2 * distance_field_->GetCellDiagonal();
+      if (start_distance.value() + end_distance.value() >
+          common::GetHaversineDistance(start_point, end_point) + slack) {
+        return true;
+      }
+    }
+  }
+  return !shallow_mask_->IsShallow(end_point) && shallow_mask_->IsSegmentClear(start_point, end_point);
+}
+
 time_t TimeScorer::GetArrivalTime(int start_id, int end_id, time_t depart_time) {
   const auto start_point = route_points_.at(start_id);
   const auto end_point = route_points_.at(end_id);
@@ -4,6 +4,8 @@
 #include "cases/helpers/route_helpers.h"
 #include "cases/scorers/iscore.h"
 #include "clients/db_client.h"
+#include "entities/danger_distance_field.h"
+#include "entities/shallow_mask.h"
 
 namespace marine_navi::cases::scorers {
 
@@ -11,17 +13,27 @@ class TimeScorer : public IScorer {
 public:
   TimeScorer(const entities::ShipPerformanceInfo& info,
              const std::vector<common::Point>& route_points,
-             std::shared_ptr<clients::DbClient> db_client, time_t min_time);
+             std::shared_ptr<clients::DbClient> db_client, time_t min_time,
+             std::shared_ptr<const entities::ShallowMask> shallow_mask = nullptr,
+             std::shared_ptr<const entities::DangerDistanceField> distance_field = nullptr);
 
   int64_t GetScore(int start_id, int end_id, time_t depart_time) override;
   time_t GetArrivalTime(int start_id, int end_id, time_t depart_time) override;
 
+private:
+  // @return speed in the point with the closest forecast
+  double GetSpeed(int point_id, time_t time) const;
+  bool IsEdgeSafe(common::Point start_point, common::Point end_point) const;
+
 private:
   const entities::ShipPerformanceInfo ship_performance_info_;
   const std::vector<common::Point> route_points_;
   std::shared_ptr<clients::DbClient> db_client_;
   const time_t min_time_;
   const helpers::ForecastAccessor forecast_accessor_;
+  const std::shared_ptr<const entities::ShallowMask> shallow_mask_;
+  const std::shared_ptr<const entities::DangerDistanceField> distance_field_;
+  // used only when there is no shallow mask for loaded depths
   const std::vector<std::vector<entities::DepthPoint> > danger_depth_points_;
 };
 
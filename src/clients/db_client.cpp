@@ -7,6 +7,8 @@
 #include "ocpn_plugin.h"
 
 #include <iomanip>
+#include <mutex>
+#include <sstream>
 #include <string>
 
 namespace marine_navi::clients {
@@ -18,6 +20,9 @@ using SingleArgVar = clients::query_builder::SingleArgVar;
 using ComposedArgVar = clients::query_builder::ComposedArgVar;
 using Point = common::Point;
 
+// the newest route check results kept in the database, older ones are evicted on insert
+const int64_t kMaxScanResultCount = 1000;
+
 template <
     typename RecordType,
     typename FormatFunc,
@@ -49,10 +54,71 @@ std::vector<std::string> MakeBatchQuery(
   return result;
 }
 
+void AppendRingWkt(std::stringstream& ss, const common::Polygon& ring) {
+  ss << "(";
+  for (const auto& point : ring.Points) {
+    ss << point.X() << " " << point.Y() << ", ";
+  }
+  ss << ring.Points[0].X() << " " << ring.Points[0].Y() << ")";
+}
+
+std::string MakePolygonWkt(const entities::ShoalPolygon& polygon) {
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(10) << "POLYGON(";
+  AppendRingWkt(ss, polygon.outer);
+  for (const auto& hole : polygon.holes) {
+    ss << ", ";
+    AppendRingWkt(ss, hole);
+  }
+  ss << ")";
+  return ss.str();
+}
+
+// @return polygons of POLYGON or MULTIPOLYGON wkt string, the first ring of each polygon is outer
+std::vector<std::vector<common::Polygon>> ParsePolygonsWkt(const std::string& wkt) {
+  std::vector<std::vector<common::Polygon>> result;
+  const int ring_depth = wkt.rfind("MULTIPOLYGON", 0) == 0 ? 3 : 2;
+  int depth = 0;
+  for (size_t i = 0; i < wkt.size(); ++i) {
+    if (wkt[i] == '(') {
+      ++depth;
+      if (depth == ring_depth - 1) {
+        result.emplace_back();
+      }
+      if (depth != ring_depth) {
+        continue;
+      }
+      const size_t end = wkt.find(')', i);
+      if (end == std::string::npos) {
+        throw std::runtime_error("invalid wkt string " + wkt);
+      }
+      std::string coords = wkt.substr(i + 1, end - i - 1);
+      std::replace(coords.begin(), coords.end(), ',', ' ');
+      std::istringstream ss(coords);
+      common::Polygon ring;
+      Point point;
+      while (ss >> point.Lon >> point.Lat) {
+        ring.Points.push_back(point);
+      }
+      // wkt rings repeat the first point at the end
+      if (ring.Points.size() > 1) {
+        ring.Points.pop_back();
+      }
+      result.back().push_back(std::move(ring));
+      i = end;
+      --depth;
+    } else if (wkt[i] == ')') {
+      --depth;
+    }
+  }
+  return result;
+}
+
 }  // namespace
 
 int64_t DbClient::InsertForecast(
     marine_navi::entities::ForecastsSource source) {
+  std::lock_guard<std::mutex> lock(mutex_);
   const std::string kQueryName = "kInsertForecast";
   const auto& query_template = query_storage_->GetTemplate(kQueryName);
 
@@ -65,6 +131,7 @@ int64_t DbClient::InsertForecast(
 void DbClient::InsertForecastRecordBatch(
     const std::vector<marine_navi::entities::ForecastRecord>& records,
     int64_t forecastId) {
+  std::lock_guard<std::mutex> lock(mutex_);
   const std::string kQueryName = "kInserForecastRecordBatchQuery";
   const auto& query_template = query_storage_->GetTemplate(kQueryName);
 
@@ -102,7 +169,9 @@ std::vector<std::tuple<entities::ForecastPoint, double, int>>
 DbClient::SelectClosestForecasts(
     const std::vector<common::Point>& route_points,
     const double max_distance_rad,
-    const time_t& min_date) {
+    const time_t& min_date,
+    std::optional<time_t> max_date) {
+  std::lock_guard<std::mutex> lock(mutex_);
   const std::string kQueryName = "kSelectClosestForecasts";
   const auto& query_template = query_storage_->GetTemplate(kQueryName);
 
@@ -114,10 +183,10 @@ DbClient::SelectClosestForecasts(
     });
   }
   const std::string date = common::ToString(min_date);
-  const std::string max_date = common::ToString(min_date + 2*24*60*60);
+  const std::string end_date = common::ToString(max_date.value_or(min_date + 2*24*60*60));
 
   const auto query =
-      query_template.MakeQuery(query_builder::ComposeArguments(points_with_id, max_distance_rad, date, max_date));
+      query_template.MakeQuery(query_builder::ComposeArguments(points_with_id, max_distance_rad, date, end_date));
 
   SQLite::Statement st(*db_, query);
   std::vector<std::tuple<entities::ForecastPoint, double, int>> result;
@@ -142,6 +211,7 @@ DbClient::SelectClosestForecasts(
 }
 
 Point DbClient::SelectForecastLocation(int forecast_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
   const std::string kQueryName = "kSelectForecastLocation";
   const auto& query_template = query_storage_->GetTemplate(kQueryName);
 
@@ -158,6 +228,33 @@ Point DbClient::SelectForecastLocation(int forecast_id) {
   return Point{};
 }
 
+int64_t DbClient::SelectLastForecastId() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (last_forecast_id_.has_value()) {
+    return last_forecast_id_.value();
+  }
+  const std::string kQueryName = "kSelectLastForecastId";
+  const auto& query_template = query_storage_->GetTemplate(kQueryName);
+
+  const auto query = query_template.MakeQuery({});
+  last_forecast_id_ = db_->execAndGet(query).getInt64();
+  return last_forecast_id_.value();
+}
+
+std::vector<double> DbClient::SelectForecastLatitudes(int64_t forecast_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const std::string kQueryName = "kSelectForecastLatitudes";
+  const auto& query_template = query_storage_->GetTemplate(kQueryName);
+
+  const auto query = query_template.MakeQuery(query_builder::ComposeArguments(forecast_id));
+  SQLite::Statement st(*db_, query);
+  std::vector<double> result;
+  while (st.executeStep()) {
+    result.push_back(st.getColumn(0).getDouble());
+  }
+  return result;
+}
+
 std::shared_ptr<SQLite::Database> CreateDatabase(
     std::string db_name,
     std::shared_ptr<query_builder::SqlQueryStorage> query_storage) {
@@ -194,6 +291,7 @@ std::shared_ptr<SQLite::Database> CreateDatabase(
 }
 
 void DbClient::InsertDepthPointBatch(const std::vector<entities::DepthPoint>& records) {
+  std::lock_guard<std::mutex> lock(mutex_);
   const std::string kQueryName = "kInsertDepths";
   const auto& query_template = query_storage_->GetTemplate(kQueryName);
   auto format_func = [](const entities::DepthPoint& record) {
@@ -213,7 +311,128 @@ void DbClient::InsertDepthPointBatch(const std::vector<entities::DepthPoint>& re
   // trans.commit();
 }
 
+void DbClient::InsertDepthGrid(const entities::RasterGeometry& geometry) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const std::string kQueryName = "kInsertDepthGrid";
+  const auto& query_template = query_storage_->GetTemplate(kQueryName);
+
+  // raster bounds need more precision than the default double formatting gives
+  auto to_precise = [](double value) { return common::StringFormat("%.10lf", value); };
+  const auto query = query_template.MakeQuery(query_builder::ComposeArguments(
+      BaseArgVar{to_precise(geometry.min_lat)},
+      BaseArgVar{to_precise(geometry.min_lon)},
+      BaseArgVar{to_precise(geometry.cell_size)},
+      BaseArgVar{static_cast<int64_t>(geometry.n_rows)},
+      BaseArgVar{static_cast<int64_t>(geometry.n_cols)}));
+  db_->exec(query);
+}
+
+std::vector<entities::DepthGridInfo> DbClient::SelectDepthGrids() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (depth_grids_.has_value()) {
+    return depth_grids_.value();
+  }
+  const std::string kQueryName = "kSelectDepthGrids";
+  const auto& query_template = query_storage_->GetTemplate(kQueryName);
+
+  const auto query = query_template.MakeQuery({});
+  SQLite::Statement st(*db_, query);
+  std::vector<entities::DepthGridInfo> result;
+  while (st.executeStep()) {
+    result.push_back(entities::DepthGridInfo{
+      .id = st.getColumn(0).getInt64(),
+      .geometry = entities::RasterGeometry{
+        .min_lat = st.getColumn(1).getDouble(),
+        .min_lon = st.getColumn(2).getDouble(),
+        .cell_size = st.getColumn(3).getDouble(),
+        .n_rows = static_cast<uint32_t>(st.getColumn(4).getInt()),
+        .n_cols = static_cast<uint32_t>(st.getColumn(5).getInt()),
+      },
+    });
+  }
+  depth_grids_ = result;
+  return result;
+}
+
+std::vector<common::Point> DbClient::SelectShallowDepthPoints(double draft) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const std::string kQueryName = "kSelectShallowDepthPoints";
+  const auto& query_template = query_storage_->GetTemplate(kQueryName);
+
+  const auto query = query_template.MakeQuery(query_builder::ComposeArguments(draft));
+  SQLite::Statement st(*db_, query);
+  std::vector<common::Point> result;
+  while (st.executeStep()) {
+    result.push_back(Point{st.getColumn(0).getDouble(), st.getColumn(1).getDouble()});
+  }
+  return result;
+}
+
+void DbClient::InsertShoalPolygons(const std::vector<entities::ShoalPolygon>& polygons) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const std::string kQueryName = "kInsertShoalPolygons";
+  const auto& query_template = query_storage_->GetTemplate(kQueryName);
+  auto format_func = [](const entities::ShoalPolygon& polygon) {
+    return std::vector<SingleArgVar>{
+        BaseArgVar{polygon.draft},
+        BaseArgVar{MakePolygonWkt(polygon)},
+        BaseArgVar{common::StringFormat("%.10lf", polygon.tolerance)}
+    };
+  };
+  const auto queries = MakeBatchQuery(polygons, query_template, format_func);
+
+  SQLite::Transaction trans(*db_);
+  for (const auto& query : queries) {
+    db_->exec(query);
+  }
+  trans.commit();
+}
+
+std::optional<double> DbClient::SelectShoalDraft(double draft) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const std::string kQueryName = "kSelectShoalDraft";
+  const auto& query_template = query_storage_->GetTemplate(kQueryName);
+
+  const auto query = query_template.MakeQuery(query_builder::ComposeArguments(draft));
+  const auto column = db_->execAndGet(query);
+  if (column.isNull()) {
+    return std::nullopt;
+  }
+  return column.getDouble();
+}
+
+std::vector<entities::ShoalPolygon> DbClient::SelectShoalPolygonsInZone(
+    const common::Polygon& zone, double shoal_draft, double margin, double tolerance) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const std::string kQueryName = "kSelectShoalPolygonsInZone";
+  const auto& query_template = query_storage_->GetTemplate(kQueryName);
+
+  const auto query = query_template.MakeQuery(query_builder::ComposeArguments(
+      BaseArgVar{zone}, shoal_draft,
+      BaseArgVar{common::StringFormat("%.10lf", margin)},
+      BaseArgVar{common::StringFormat("%.10lf", tolerance)}));
+  SQLite::Statement st(*db_, query);
+  std::vector<entities::ShoalPolygon> result;
+  while (st.executeStep()) {
+    for (auto& rings : ParsePolygonsWkt(st.getColumn(0).getText())) {
+      if (rings.empty()) {
+        continue;
+      }
+      entities::ShoalPolygon polygon{
+        .draft = shoal_draft,
+        .outer = std::move(rings[0]),
+        .holes = std::vector<common::Polygon>(std::make_move_iterator(rings.begin() + 1),
+                                              std::make_move_iterator(rings.end())),
+        .tolerance = tolerance,
+      };
+      result.push_back(std::move(polygon));
+    }
+  }
+  return result;
+}
+
 std::vector<std::vector<entities::DepthPoint> > DbClient::SelectHazardDepthPoints(const std::vector<common::Point>& points, double height, double distance) {
+  std::lock_guard<std::mutex> lock(mutex_);
   const std::string kQueryName = "kSelectHazardDepthPoints";
   const auto& query_template = query_storage_->GetTemplate(kQueryName);
 
@@ -238,32 +457,59 @@ std::vector<std::vector<entities::DepthPoint> > DbClient::SelectHazardDepthPoint
   return result;
 }
 
-std::vector<std::vector<entities::DepthPoint> > DbClient::SelectHazardDepthPointsInAngle(std::vector<common::Polygon> triangles, double height) {
-  const std::string kQueryName = "kSelectHazardDepthPointsInAngle";
+std::vector<std::optional<entities::DepthPoint> > DbClient::SelectShallowestDepthPointsInTiles(const std::vector<common::Polygon>& tiles) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const std::string kQueryName = "kSelectShallowestDepthPointsInTiles";
   const auto& query_template = query_storage_->GetTemplate(kQueryName);
 
-  std::vector<std::vector<SingleArgVar> > triangles_with_id(triangles.size());
-  for(size_t i = 0; i < triangles.size(); ++i) {
-    triangles_with_id[i] = std::vector<SingleArgVar>{
+  std::vector<std::vector<SingleArgVar> > tiles_with_id(tiles.size());
+  for(size_t i = 0; i < tiles.size(); ++i) {
+    tiles_with_id[i] = std::vector<SingleArgVar>{
       BaseArgVar{static_cast<int64_t>(i)},
-      BaseArgVar{triangles[i]},
-      BaseArgVar{height}
+      BaseArgVar{tiles[i]},
     };
   }
 
-  const auto query = query_template.MakeQuery(query_builder::ComposeArguments(triangles_with_id));
+  const auto query = query_template.MakeQuery(query_builder::ComposeArguments(tiles_with_id));
   SQLite::Statement st(*db_, query);
-  std::vector<std::vector<entities::DepthPoint> > result(triangles.size());
+  std::vector<std::optional<entities::DepthPoint> > result(tiles.size());
   while (st.executeStep()) {
-    const double depth = st.getColumn(0).getDouble();
-    const Point point = Point::FromWktString(st.getColumn(1).getText());
-    const int triangle_id = st.getColumn(2).getInt();
-    result[triangle_id].push_back({entities::DepthPoint{point, depth}});
+    const int tile_id = st.getColumn(0).getInt();
+    const double depth = st.getColumn(1).getDouble();
+    const Point point = Point::FromWktString(st.getColumn(2).getText());
+    result[tile_id] = entities::DepthPoint{point, depth};
+  }
+  return result;
+}
+
+std::vector<std::vector<entities::DepthPoint> > DbClient::SelectShallowDepthPointsInTiles(
+    const std::vector<common::Polygon>& tiles, double max_water_depth) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const std::string kQueryName = "kSelectShallowDepthPointsInTiles";
+  const auto& query_template = query_storage_->GetTemplate(kQueryName);
+
+  std::vector<std::vector<SingleArgVar> > tiles_with_id(tiles.size());
+  for(size_t i = 0; i < tiles.size(); ++i) {
+    tiles_with_id[i] = std::vector<SingleArgVar>{
+      BaseArgVar{static_cast<int64_t>(i)},
+      BaseArgVar{tiles[i]},
+    };
+  }
+
+  const auto query = query_template.MakeQuery(query_builder::ComposeArguments(tiles_with_id, max_water_depth));
+  SQLite::Statement st(*db_, query);
+  std::vector<std::vector<entities::DepthPoint> > result(tiles.size());
+  while (st.executeStep()) {
+    const int tile_id = st.getColumn(0).getInt();
+    const double depth = st.getColumn(1).getDouble();
+    const Point point = Point::FromWktString(st.getColumn(2).getText());
+    result[tile_id].push_back(entities::DepthPoint{point, depth});
   }
   return result;
 }
 
 void DbClient::InsertSafePoints(const std::vector<entities::SafePoint>& save_points) {
+  std::lock_guard<std::mutex> lock(mutex_);
   const std::string kQueryName = "kInsertSafePoints";
   const auto& query_template = query_storage_->GetTemplate(kQueryName);
 
@@ -281,7 +527,8 @@ void DbClient::InsertSafePoints(const std::vector<entities::SafePoint>& save_poi
 }
 
 std::vector<entities::SafePoint> DbClient::SelectSafePoints() {
-  const std::string kQueryName = "kInsertSafePoints";
+  std::lock_guard<std::mutex> lock(mutex_);
+  const std::string kQueryName = "kSelectSafePoints";
   const auto& query_template = query_storage_->GetTemplate(kQueryName);
 
   const auto query = query_template.MakeQuery({});
@@ -295,4 +542,82 @@ std::vector<entities::SafePoint> DbClient::SelectSafePoints() {
   return result;
 }
 
+std::optional<entities::diagnostic::RouteValidateDiagnostic> DbClient::SelectScanResult(
+    const std::string& scan_key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const std::string kQueryName = "kSelectScanResult";
+  const auto& query_template = query_storage_->GetTemplate(kQueryName);
+
+  const auto query = query_template.MakeQuery(query_builder::ComposeArguments(BaseArgVar{scan_key}));
+  SQLite::Statement st(*db_, query);
+  std::optional<entities::diagnostic::RouteValidateDiagnostic> result;
+  while (st.executeStep()) {
+    if (!result.has_value()) {
+      result = entities::diagnostic::RouteValidateDiagnostic{
+        static_cast<entities::diagnostic::RouteValidateDiagnostic::DiagnosticResultType>(st.getColumn(0).getInt()),
+        {}
+      };
+    }
+    // the result without hazards is joined with nulls
+    if (st.getColumn(1).isNull()) {
+      continue;
+    }
+    result->hazard_points.emplace_back(
+        Point::FromWktString(st.getColumn(1).getText()),
+        static_cast<time_t>(st.getColumn(2).getInt64()),
+        static_cast<time_t>(st.getColumn(3).getInt64()),
+        static_cast<time_t>(st.getColumn(4).getInt64()),
+        static_cast<entities::diagnostic::HazardReason>(st.getColumn(5).getInt()),
+        st.getColumn(6).getDouble(),
+        static_cast<uint32_t>(st.getColumn(7).getInt64()));
+  }
+  return result;
+}
+
+void DbClient::InsertScanResult(const std::string& scan_key,
+                                const entities::diagnostic::RouteValidateDiagnostic& diagnostic) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto& delete_template = query_storage_->GetTemplate("kDeleteScanResult");
+  const auto& insert_template = query_storage_->GetTemplate("kInsertScanResult");
+  const auto& hazards_template = query_storage_->GetTemplate("kInsertScanResultHazards");
+  const auto& evict_template = query_storage_->GetTemplate("kDeleteOldScanResults");
+
+  SQLite::Transaction trans(*db_);
+  db_->exec(delete_template.MakeQuery(query_builder::ComposeArguments(BaseArgVar{scan_key})));
+  const int64_t scan_result_id =
+      InsertQuery(insert_template.MakeQuery(query_builder::ComposeArguments(BaseArgVar{scan_key}, diagnostic.result)));
+
+  auto format_func = [&](const entities::diagnostic::DiagnosticHazardPoint& point) -> std::vector<SingleArgVar> {
+    return std::vector<SingleArgVar>{
+        BaseArgVar{scan_result_id},
+        BaseArgVar{static_cast<int64_t>(point.GetCheckTime())},
+        BaseArgVar{static_cast<int64_t>(point.GetExpectedTime())},
+        BaseArgVar{static_cast<int64_t>(point.GetLastExpectedTime())},
+        BaseArgVar{static_cast<int64_t>(point.GetReason())},
+        BaseArgVar{point.GetValue()},
+        BaseArgVar{static_cast<int64_t>(point.GetCount())},
+        BaseArgVar{point.GetLocation()}
+    };
+  };
+  for (const auto& query : MakeBatchQuery(diagnostic.hazard_points, hazards_template, format_func)) {
+    db_->exec(query);
+  }
+  db_->exec(evict_template.MakeQuery(query_builder::ComposeArguments(BaseArgVar{kMaxScanResultCount})));
+  trans.commit();
+}
+
+void DbClient::ResetCachedVersions() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  last_forecast_id_.reset();
+  depth_grids_.reset();
+}
+
+void DbClient::DeleteScanResults() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const std::string kQueryName = "kDeleteScanResults";
+  const auto& query_template = query_storage_->GetTemplate(kQueryName);
+
+  db_->exec(query_template.MakeQuery({}));
+}
+
 }  // namespace marine_navi::clients
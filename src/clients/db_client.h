@@ -1,6 +1,8 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 
 #include <SQLiteCpp/Database.h>
@@ -9,15 +11,19 @@
 #include "clients/query_builder/sql_query_storage.h"
 #include "common/geom.h"
 #include "common/utils.h"
+#include "entities/depth_grid.h"
 #include "entities/depth_point.h"
+#include "entities/diagnostic/diagnostic.h"
 #include "entities/forecast_point.h"
 #include "entities/safe_point.h"
+#include "entities/shoal_polygon.h"
 #include "entities/weather_forecast.h"
 
 namespace marine_navi::clients {
 
 using SqlQueryStorage = query_builder::SqlQueryStorage;
 
+// Shared by the UI thread and background workers, every query runs under one lock
 class DbClient {
 public:
   DbClient(std::shared_ptr<SQLite::Database> db, std::shared_ptr<SqlQueryStorage> query_storage) 
@@ -27,31 +33,68 @@ public:
   void InsertForecastRecordBatch(const std::vector<entities::ForecastRecord>& records,
                                  int64_t forecastId);
 
-// @return forecast point, distance to point and point id
+// @return forecast point, distance to point and point id of forecasts ending in [min_date, max_date],
+// max_date is 48 hours after min_date if not set
   std::vector<std::tuple<entities::ForecastPoint, double, int>>
   SelectClosestForecasts(
       const std::vector<common::Point>& route_points,
       const double max_distance_rad,
-      const time_t& min_date);
+      const time_t& min_date,
+      std::optional<time_t> max_date = std::nullopt);
   common::Point SelectForecastLocation(int forecast_id);
+  // @return id of the latest loaded forecast, 0 if there are no forecasts. Cached until ResetCachedVersions
+  int64_t SelectLastForecastId();
+  // @return distinct latitudes of the forecast locations in increasing order
+  std::vector<double> SelectForecastLatitudes(int64_t forecast_id);
 
   void InsertDepthPointBatch(const std::vector<entities::DepthPoint>& depth_points);
+  void InsertDepthGrid(const entities::RasterGeometry& geometry);
+  // cached until ResetCachedVersions
+  std::vector<entities::DepthGridInfo> SelectDepthGrids();
+  // @return locations of depth points where depth is not enough for the draft
+  std::vector<common::Point> SelectShallowDepthPoints(double draft);
+
+  void InsertShoalPolygons(const std::vector<entities::ShoalPolygon>& polygons);
+  // @return the smallest draft of stored shoal polygons which is not less than the draft. Polygons of the draft
+  // may be missing for depth grids loaded without it
+  std::optional<double> SelectShoalDraft(double draft);
+  // @return shoal polygons of the draft intersecting the zone, extended by margin and simplified
+  // with tolerance, both in degrees
+  std::vector<entities::ShoalPolygon> SelectShoalPolygonsInZone(const common::Polygon& zone, double shoal_draft,
+                                                                double margin, double tolerance);
 
   // @return A list of hazard points based on distance
   std::vector<std::vector<entities::DepthPoint> > SelectHazardDepthPoints(const std::vector<common::Point>& points, double height, double distance);
 
-  // @return A list of hazard points for each triangle
-  std::vector<std::vector<entities::DepthPoint> > SelectHazardDepthPointsInAngle(std::vector<common::Polygon> triagnles, double height);
+  // @return the shallowest depth point of each corridor tile, tiles are looked up in the spatial index one by one
+  std::vector<std::optional<entities::DepthPoint> > SelectShallowestDepthPointsInTiles(const std::vector<common::Polygon>& tiles);
+  // @return depth points of each corridor tile where water is not deeper than max_water_depth
+  std::vector<std::vector<entities::DepthPoint> > SelectShallowDepthPointsInTiles(const std::vector<common::Polygon>& tiles,
+                                                                                 double max_water_depth);
 
   void InsertSafePoints(const std::vector<entities::SafePoint>& save_points);
   std::vector<entities::SafePoint> SelectSafePoints();
 
+  // @return the stored result of a route check, nullopt if there is no result with the key
+  std::optional<entities::diagnostic::RouteValidateDiagnostic> SelectScanResult(const std::string& scan_key);
+  // replaces the result stored with the same key, only the newest results are kept
+  void InsertScanResult(const std::string& scan_key,
+                        const entities::diagnostic::RouteValidateDiagnostic& diagnostic);
+  // drops the cached forecast id and depth grids, called by the loaders when a load completes
+  void ResetCachedVersions();
+  // drops all stored route check results, called when forecasts or depths are loaded
+  void DeleteScanResults();
+
 private:
   int64_t InsertQuery(std::string query);
 
 private:
   std::shared_ptr<SQLite::Database> db_;
   std::shared_ptr<SqlQueryStorage> query_storage_;
+  std::mutex mutex_;
+  // versions of the loaded data, checked by route monitoring every update
+  std::optional<int64_t> last_forecast_id_;
+  std::optional<std::vector<entities::DepthGridInfo>> depth_grids_;
 };
 
 std::shared_ptr<SQLite::Database> CreateDatabase(std::string db_name, std::shared_ptr<SqlQueryStorage> query_storage);
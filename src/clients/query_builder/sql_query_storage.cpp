@@ -35,7 +35,8 @@ std::string PolygonVarToString(const common::Polygon& polygon) {
     std::runtime_error("polygn is empty");
   }
   std::stringstream ss;
-  ss << std::fixed << std::setprecision(3) << "MakePolygon(GeomFromText('LINESTRING(";
+  // corridor tiles are a few hundred meters wide, so vertices keep about 0.1 m
+  ss << std::fixed << std::setprecision(6) << "MakePolygon(GeomFromText('LINESTRING(";
 
   const auto& points = polygon.Points;
   for(size_t i = 0; i < points.size(); ++i) {
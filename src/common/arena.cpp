@@ -0,0 +1,45 @@
+#include "arena.h"
+
+namespace marine_navi::common {
+
+void* Arena::BlockCounter::do_allocate(size_t bytes, size_t alignment) {
+  ++count_;
+  return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void Arena::BlockCounter::do_deallocate(void* p, size_t bytes, size_t alignment) {
+  std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+}
+
+bool Arena::BlockCounter::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+  return this == &other;
+}
+
+Arena::Arena(size_t initial_size)
+    : mutex_(), blocks_(), buffer_(initial_size, &blocks_), allocation_count_(0), allocated_bytes_(0) {}
+
+Arena::Stats Arena::GetStats() const {
+  std::lock_guard lock(mutex_);
+  return Stats{
+    .allocation_count = allocation_count_,
+    .allocated_bytes = allocated_bytes_,
+    .block_count = blocks_.GetCount(),
+  };
+}
+
+void* Arena::do_allocate(size_t bytes, size_t alignment) {
+  std::lock_guard lock(mutex_);
+  ++allocation_count_;
+  allocated_bytes_ += bytes;
+  return buffer_.allocate(bytes, alignment);
+}
+
+void Arena::do_deallocate(void*, size_t, size_t) {
+  // memory is released with the arena
+}
+
+bool Arena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+  return this == &other;
+}
+
+}  // namespace marine_navi::common
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+
+namespace marine_navi::common {
+
+// Monotonic memory for intermediates of one run, deallocation is a no-op and everything is released at once
+// when the arena is destroyed. Allocations are serialized, so containers of one run may be filled concurrently.
+class Arena : public std::pmr::memory_resource {
+public:
+  struct Stats {
+    size_t allocation_count;
+    size_t allocated_bytes;
+    size_t block_count;  // blocks taken from the heap
+  };
+
+  explicit Arena(size_t initial_size = kInitialSize);
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  Stats GetStats() const;
+
+private:
+  // counts blocks the monotonic buffer takes from the heap
+  class BlockCounter : public std::pmr::memory_resource {
+  public:
+    size_t GetCount() const { return count_; }
+
+  private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+  private:
+    size_t count_ = 0;
+  };
+
+  void* do_allocate(size_t bytes, size_t alignment) override;
+  void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+private:
+  static constexpr size_t kInitialSize = 64 * 1024;
+
+  mutable std::mutex mutex_;
+  BlockCounter blocks_;
+  std::pmr::monotonic_buffer_resource buffer_;
+  size_t allocation_count_;
+  size_t allocated_bytes_;
+};
+
+}  // namespace marine_navi::common
@@ -21,6 +21,25 @@ int sign(double x) {
     return (x < 0) ? -1 : 1;
 }
 
+void SimplifyChain(const std::vector<Point>& points, size_t begin, size_t end, double tolerance,
+                   std::vector<bool>& keep) {
+  const Segment chord{points[begin], points[end]};
+  double max_distance = 0;
+  size_t farthest = begin;
+  for (size_t i = begin + 1; i < end; ++i) {
+    const double distance = GetDistanceToSegment(points[i], chord);
+    if (distance > max_distance) {
+      max_distance = distance;
+      farthest = i;
+    }
+  }
+  if (max_distance > tolerance) {
+    keep[farthest] = true;
+    SimplifyChain(points, begin, farthest, tolerance, keep);
+    SimplifyChain(points, farthest, end, tolerance, keep);
+  }
+}
+
 } // namespace
 
 double& Point::X() { return Lon; }
@@ -90,6 +109,90 @@ double GetHaversineDistance(const Segment& segment) {
   return GetHaversineDistance(segment.Start, segment.End);
 }
 
+double GetDistanceToSegment(const Point& point, const Segment& segment) {
+  const auto direction = segment.End - segment.Start;
+  const auto point_vec = point - segment.Start;
+  const double length2 = DotProduct(direction, direction);
+  if (length2 < kEps * kEps) {
+    return std::sqrt(DotProduct(point_vec, point_vec));
+  }
+  const double k = std::clamp(DotProduct(direction, point_vec) / length2, 0.0, 1.0);
+  const auto diff = point_vec - direction * k;
+  return std::sqrt(DotProduct(diff, diff));
+}
+
+bool IsSegmentsCrossing(const Segment& lhs, const Segment& rhs) {
+  // exact signs, shared endpoints give exact zero and must not count as crossing
+  const auto sign = [](double x) { return (x > 0) - (x < 0); };
+  const auto lhs_direction = lhs.End - lhs.Start;
+  const auto rhs_direction = rhs.End - rhs.Start;
+  const int d1 = sign(CrossProduct(lhs_direction, rhs.Start - lhs.Start));
+  const int d2 = sign(CrossProduct(lhs_direction, rhs.End - lhs.Start));
+  const int d3 = sign(CrossProduct(rhs_direction, lhs.Start - rhs.Start));
+  const int d4 = sign(CrossProduct(rhs_direction, lhs.End - rhs.Start));
+  return d1 * d2 < 0 && d3 * d4 < 0;
+}
+
+double GetSignedArea(const Polygon& polygon) {
+  const auto& points = polygon.Points;
+  double area = 0;
+  for (size_t i = 0; i < points.size(); ++i) {
+    area += CrossProduct(points[i], points[(i + 1) % points.size()]);
+  }
+  return area / 2;
+}
+
+bool IsInsidePolygon(const Point& point, const Polygon& polygon) {
+  const auto& points = polygon.Points;
+  bool inside = false;
+  for (size_t i = 0, j = points.size() - 1; i < points.size(); j = i++) {
+    const auto& a = points[i];
+    const auto& b = points[j];
+    if ((a.Y() > point.Y()) != (b.Y() > point.Y()) &&
+        point.X() < (b.X() - a.X()) * (point.Y() - a.Y()) / (b.Y() - a.Y()) + a.X()) {
+      inside = !inside;
+    }
+  }
+  return inside;
+}
+
+Polygon SimplifyRing(const Polygon& ring, double tolerance) {
+  const auto& points = ring.Points;
+  if (points.size() < 4) {
+    return ring;
+  }
+
+  // the ring is split at the vertex farthest from the first one, both halves are open chains
+  size_t farthest = 0;
+  double max_distance = 0;
+  for (size_t i = 1; i < points.size(); ++i) {
+    const auto diff = points[i] - points[0];
+    const double distance = DotProduct(diff, diff);
+    if (distance > max_distance) {
+      max_distance = distance;
+      farthest = i;
+    }
+  }
+
+  std::vector<Point> closed(points);
+  closed.push_back(points[0]);
+  std::vector<bool> keep(closed.size(), false);
+  keep[0] = keep[farthest] = true;
+  SimplifyChain(closed, 0, farthest, tolerance, keep);
+  SimplifyChain(closed, farthest, closed.size() - 1, tolerance, keep);
+
+  Polygon result;
+  for (size_t i = 0; i < points.size(); ++i) {
+    if (keep[i]) {
+      result.Points.push_back(points[i]);
+    }
+  }
+  if (result.Points.size() < 3) {
+    return ring;
+  }
+  return result;
+}
+
 Point Point::FromWktString(const std::string& wkt) {
   const std::string input = ::marine_navi::common::TrimSpace(wkt);
   if (input.rfind("POINT(", 0) != 0) {
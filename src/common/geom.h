@@ -7,6 +7,8 @@
 namespace marine_navi::common {
 
 const double kEps = 1e-5;
+// length of a degree of latitude, and of longitude on the equator
+constexpr double kMetersPerDegree = 111320;
 
 struct Point {
   double& X();
@@ -49,4 +51,16 @@ struct Polygon {
 double GetHaversineDistance(Point lhs, Point rhs);
 double GetHaversineDistance(const Segment& segment);
 
+// @return planar distance in coordinate units from point to the closest point of segment
+double GetDistanceToSegment(const Point& point, const Segment& segment);
+
+// @return true if segments cross at a point which is inner for both of them
+bool IsSegmentsCrossing(const Segment& lhs, const Segment& rhs);
+
+// @return planar area of the ring, positive for counterclockwise order (X is Lon, Y is Lat)
+double GetSignedArea(const Polygon& polygon);
+bool IsInsidePolygon(const Point& point, const Polygon& polygon);
+// Douglas-Peucker simplification of the closed ring, every removed vertex stays within tolerance
+Polygon SimplifyRing(const Polygon& ring, double tolerance);
+
 } // namespace marine_navi::common
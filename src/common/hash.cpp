@@ -0,0 +1,51 @@
+#include "hash.h"
+
+#include <iomanip>
+#include <sstream>
+
+namespace marine_navi::common {
+
+namespace {
+
+constexpr uint64_t kFnvPrime = 1099511628211ULL;
+
+}  // namespace
+
+Hasher& Hasher::Add(int64_t value) {
+  AddBytes(&value, sizeof(value));
+  return *this;
+}
+
+Hasher& Hasher::Add(double value) {
+  if (value == 0) {
+    value = 0;  // -0.0 and 0.0 must give the same hash
+  }
+  AddBytes(&value, sizeof(value));
+  return *this;
+}
+
+Hasher& Hasher::Add(const Point& point) {
+  return Add(point.Lat).Add(point.Lon);
+}
+
+Hasher& Hasher::Add(const std::string& value) {
+  Add(static_cast<int64_t>(value.size()));
+  AddBytes(value.data(), value.size());
+  return *this;
+}
+
+void Hasher::AddBytes(const void* data, size_t size) {
+  const auto* bytes = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < size; ++i) {
+    hash_ ^= bytes[i];
+    hash_ *= kFnvPrime;
+  }
+}
+
+std::string ToHexString(uint64_t hash) {
+  std::ostringstream ss;
+  ss << std::hex << std::setw(16) << std::setfill('0') << hash;
+  return ss.str();
+}
+
+}  // namespace marine_navi::common
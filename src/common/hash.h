@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "common/geom.h"
+
+namespace marine_navi::common {
+
+// FNV-1a 64 bit hash, stable between runs so it can be persisted
+class Hasher {
+public:
+  Hasher& Add(int64_t value);
+  Hasher& Add(double value);
+  Hasher& Add(const Point& point);
+  Hasher& Add(const std::string& value);
+
+  uint64_t Get() const { return hash_; }
+
+private:
+  void AddBytes(const void* data, size_t size);
+
+private:
+  uint64_t hash_ = 14695981039346656037ULL;
+};
+
+std::string ToHexString(uint64_t hash);
+
+}  // namespace marine_navi::common
@@ -0,0 +1,72 @@
+#include "thread_pool.h"
+
+namespace marine_navi::common {
+
+ThreadPool::ThreadPool(size_t thread_count) : stopped_(false) {
+  for (size_t i = 0; i < thread_count; ++i) {
+    threads_.emplace_back([this] { Work(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock(mutex_);
+    stopped_ = true;
+  }
+  cv_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void ThreadPool::Work() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock lock(mutex_);
+      cv_.wait(lock, [this] { return stopped_ || !tasks_.empty(); });
+      if (stopped_ && tasks_.empty()) {
+        return;
+      }
+      task = std::move(tasks_.front());
+      tasks_.pop();
+    }
+    task();
+  }
+}
+
+void ParallelFor(ThreadPool& pool, size_t count, const std::function<void(size_t, size_t)>& func) {
+  if (count == 0) {
+    return;
+  }
+  const size_t chunk_count = std::min(count, pool.GetThreadCount() + 1);
+  const size_t chunk_size = (count + chunk_count - 1) / chunk_count;
+
+  std::vector<std::future<void>> futures;
+  for (size_t begin = chunk_size; begin < count; begin += chunk_size) {
+    futures.push_back(pool.Submit([&func, begin, end = std::min(begin + chunk_size, count)] {
+      func(begin, end);
+    }));
+  }
+  // every chunk must finish before return because chunks refer to func
+  std::exception_ptr error;
+  try {
+    func(0, std::min(chunk_size, count));
+  } catch (...) {
+    error = std::current_exception();
+  }
+  for (auto& future : futures) {
+    try {
+      future.get();
+    } catch (...) {
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+}  // namespace marine_navi::common
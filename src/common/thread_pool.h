@@ -0,0 +1,51 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace marine_navi::common {
+
+class ThreadPool {
+public:
+  explicit ThreadPool(size_t thread_count = std::max(1u, std::thread::hardware_concurrency()));
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  template <typename Func>
+  auto Submit(Func func) -> std::future<decltype(func())> {
+    auto task = std::make_shared<std::packaged_task<decltype(func())()>>(std::move(func));
+    auto future = task->get_future();
+    {
+      std::lock_guard lock(mutex_);
+      tasks_.push([task] { (*task)(); });
+    }
+    cv_.notify_one();
+    return future;
+  }
+
+  size_t GetThreadCount() const { return threads_.size(); }
+
+private:
+  void Work();
+
+private:
+  std::vector<std::thread> threads_;
+  std::queue<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stopped_;
+};
+
+// Runs func(begin, end) over [0, count) split into contiguous chunks on current thread and the pool.
+// Must not be called from a pool thread.
+void ParallelFor(ThreadPool& pool, size_t count, const std::function<void(size_t, size_t)>& func);
+
+}  // namespace marine_navi::common
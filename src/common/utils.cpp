@@ -48,4 +48,18 @@ time_t GetCurrentTime() {
   return std::time(nullptr);
 }
 
+size_t GetRemainingSize(std::istream& in) {
+  const auto position = in.tellg();
+  if (position < 0) {
+    throw std::runtime_error("stream position is unknown");
+  }
+  in.seekg(0, std::ios::end);
+  const auto end = in.tellg();
+  in.seekg(position);
+  if (end < position) {
+    throw std::runtime_error("stream end is unknown");
+  }
+  return static_cast<size_t>(end - position);
+}
+
 }  // namespace marine_navi::common
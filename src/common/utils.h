@@ -2,6 +2,7 @@
 
 #include <cmath>
 #include <ctime>
+#include <istream>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -33,4 +34,7 @@ std::string CurrentFormattedTime(
 
 time_t GetCurrentTime();
 
+// @return bytes from the read position to the end of the stream
+size_t GetRemainingSize(std::istream& in);
+
 }  // namespace marine_navi::common
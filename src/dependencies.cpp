@@ -4,17 +4,23 @@
 
 #include "cases/best_route_maker.h"
 #include "cases/depth_loader.h"
+#include "cases/depth_mask_provider.h"
+#include "cases/find_route_grid_cache.h"
 #include "cases/forecasts_loader.h"
 #include "cases/marine_route_scanner.h"
 #include "cases/safe_point_manager.h"
 #include "clients/db_client.h"
 #include "clients/query_builder/sql_query_storage.h"
 #include "clients/esimo.h"
+#include "common/thread_pool.h"
 #include "render_overlay.h"
 
 namespace marine_navi {
 
 namespace {
+const size_t kGridCacheMemoryBudget = 64 * 1024 * 1024;
+const std::vector<double> kShoalDrafts = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 12, 15, 20};
+
 std::shared_ptr<clients::SqlQueryStorage> MakeSqlQueryStorage() {
   wxFileName fn;
   wxString tmp_path;
@@ -26,6 +32,12 @@ std::shared_ptr<clients::SqlQueryStorage> MakeSqlQueryStorage() {
 
   return std::make_shared<clients::SqlQueryStorage>(fn.GetPath().ToStdString());
 }
+
+std::string GetCacheDirPath(const std::string& name) {
+  wxString sep = wxFileName::GetPathSeparator();
+  return (*GetpPrivateApplicationDataLocation() + sep + "plugins" + sep +
+          "marine_navi" + sep + name).ToStdString();
+}
 } // namespace 
 
 Dependencies CreateDependencies(wxWindow* ocpnCanvasWindow) {
@@ -35,13 +47,21 @@ Dependencies CreateDependencies(wxWindow* ocpnCanvasWindow) {
   deps.sql_query_storage = MakeSqlQueryStorage();
   deps.db = clients::CreateDatabase("marinenavi.db", deps.sql_query_storage);
   deps.db_client = std::make_shared<clients::DbClient>(deps.db, deps.sql_query_storage);
-  deps.depth_loader = std::make_shared<cases::DepthLoader>(deps.db_client);
-  deps.best_route_maker = std::make_shared<cases::BestRouteMaker>(deps.db_client);
+  deps.depth_loader = std::make_shared<cases::DepthLoader>(deps.db_client, kShoalDrafts);
+  deps.thread_pool = std::make_shared<common::ThreadPool>();
+  deps.depth_mask_provider = std::make_shared<cases::DepthMaskProvider>(
+      deps.db_client, deps.thread_pool, GetCacheDirPath("depth_masks"));
   deps.forecasts_loader =
       std::make_shared<cases::ForecastsLoader>(deps.db_client);
   deps.marine_route_scanner =
-      std::make_shared<cases::MarineRouteScanner>(deps.db_client);
+      std::make_shared<cases::MarineRouteScanner>(
+          deps.db_client, deps.depth_mask_provider, deps.thread_pool);
   deps.safe_point_manager = std::make_shared<cases::SafePointManager>(deps.db_client);
+  deps.find_route_grid_cache = std::make_shared<cases::FindRouteGridCache>(
+      kGridCacheMemoryBudget, GetCacheDirPath("grids"));
+  deps.best_route_maker = std::make_shared<cases::BestRouteMaker>(
+      deps.db_client, deps.safe_point_manager, deps.find_route_grid_cache,
+      deps.depth_mask_provider);
   deps.render_overlay = std::make_shared<marine_navi::RenderOverlay>(deps);
   return deps;
 }
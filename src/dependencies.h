@@ -11,12 +11,18 @@ class Database;
 namespace marine_navi {
 namespace cases {
 class BestRouteMaker;
+class FindRouteGridCache;
 class MarineRouteScanner;
 class ForecastsLoader;
 class DepthLoader;
+class DepthMaskProvider;
 class SafePointManager;
 } // namespace cases
 
+namespace common {
+class ThreadPool;
+} // namespace common
+
 namespace clients {
 class DbClient;
 namespace query_builder {
@@ -28,14 +34,17 @@ class RenderOverlay;
 
 struct Dependencies {
   std::shared_ptr<cases::BestRouteMaker> best_route_maker;
+  std::shared_ptr<cases::FindRouteGridCache> find_route_grid_cache;
   std::shared_ptr<cases::MarineRouteScanner> marine_route_scanner;
   std::shared_ptr<cases::ForecastsLoader> forecasts_loader;
   std::shared_ptr<cases::DepthLoader> depth_loader;
+  std::shared_ptr<cases::DepthMaskProvider> depth_mask_provider;
   std::shared_ptr<cases::SafePointManager> safe_point_manager;
   std::shared_ptr<marine_navi::RenderOverlay> render_overlay;
   std::shared_ptr<SQLite::Database> db;
   std::shared_ptr<clients::query_builder::SqlQueryStorage> sql_query_storage;
   std::shared_ptr<clients::DbClient> db_client;
+  std::shared_ptr<common::ThreadPool> thread_pool;
   wxWindow* ocpn_canvas_window;
 };
 
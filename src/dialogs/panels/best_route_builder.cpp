@@ -2,10 +2,15 @@
 
 #include "ocpn_plugin.h"
 
+#include "dialogs/panels/helpers.h"
+
 namespace marine_navi::dialogs::panels {
 
 namespace {
 
+// wide enough for detours around shoals along a coastal passage, the search is confined to it
+constexpr double kDefaultCorridorWidthKm = 50;
+
 PlugIn_Route_Ex* MakeRouteFromBestRouteResult(const marine_navi::cases::BestRouteResult& best_route_result) {
     PlugIn_Route_Ex* route = new PlugIn_Route_Ex;
     int id = 0;
@@ -38,6 +43,8 @@ BestRouteBuilderPanel::BestRouteBuilderPanel(wxWindow* parent, const Dependencie
     wxBoxSizer* ext_ship_sizer = new wxBoxSizer(wxVERTICAL);
     ext_ship_sizer->Add(ship_info_panel_, 1, wxALL | wxEXPAND, 5);
     ext_ship_sizer->Add(depart_time_input_, 1, wxALL | wxEXPAND, 5);
+    c_corridor_width_ = CreateLabeledTextCtrl(this, ext_ship_sizer, _("Corridor width, km"),
+                                              wxString::Format("%g", kDefaultCorridorWidthKm));
     splitter->Add(ext_ship_sizer, 1, wxALL | wxEXPAND, 5);
     splitter->Add(select_zone_panel_, 1, wxALL | wxEXPAND, 5);
     splitter->Add(select_route_panel_, 1, wxALL | wxEXPAND, 5);
@@ -64,16 +71,29 @@ void BestRouteBuilderPanel::OnMakeBestRoute(wxCommandEvent& event){
         return;
     }
 
+    std::optional<double> corridor_width;
+    if (double width_km; c_corridor_width_->GetValue().ToDouble(&width_km) && width_km > 0) {
+        corridor_width = width_km * 1000;
+    }
+
     cases::BestRouteInput input {
         .route = route,
         .bounds = bounds,
         .ship_performance_info = ship_info_panel_->GetShipInfo(),
         .depart_time = depart_time_input_->GetTime(),
+        .corridor_width = corridor_width,
         .score_type = cases::BestRouteInput::ScoreType::kTime
     };
-    const auto best_route = best_route_maker_->MakeBestRoute(input);
-    auto* render_route = MakeRouteFromBestRouteResult(best_route);
-    render_overlay_->RenderBestPath(render_route);
+    try {
+        const auto best_route = best_route_maker_->MakeBestRoute(input);
+        if (best_route.max_time_to_safety.has_value()) {
+            wxLogInfo(_T("Best route max time to safety %.0lf s"), best_route.max_time_to_safety.value());
+        }
+        auto* render_route = MakeRouteFromBestRouteResult(best_route);
+        render_overlay_->RenderBestPath(render_route);
+    } catch (const std::exception& ex) {
+        wxMessageBox(wxString::Format(_("Failed to make best route: %s"), ex.what()), "Error", wxOK | wxICON_ERROR);
+    }
 }
 
 void BestRouteBuilderPanel::BindEvents() {
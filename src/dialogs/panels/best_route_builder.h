@@ -30,6 +30,7 @@ private:
     SelectRoutePanel* select_zone_panel_;
     SelectRoutePanel* select_route_panel_;
     DepartTimeInput* depart_time_input_;
+    wxTextCtrl* c_corridor_width_;
     wxButton* b_make_best_route_;
 
     std::shared_ptr<cases::BestRouteMaker> best_route_maker_;
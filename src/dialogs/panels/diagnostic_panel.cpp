@@ -1,11 +1,12 @@
 #include "diagnostic_panel.h"
 
+#include <wx/font.h>
 #include <wx/log.h>
 #include <wx/sizer.h>
 
 namespace marine_navi::dialogs::panels {
 
-DiagnosticPanel::DiagnosticPanel(wxWindow* parent) : wxPanel(parent) {
+DiagnosticPanel::DiagnosticPanel(wxWindow* parent) : wxPanel(parent), appended_hazard_count_(0) {
   c_diagnostic_message_ =
       new wxTextCtrl(this, wxID_ANY, wxEmptyString, wxDefaultPosition,
                      wxDefaultSize, wxTE_READONLY | wxTE_MULTILINE);
@@ -19,4 +20,36 @@ void DiagnosticPanel::UpdateDiagnostic(const entities::diagnostic::RouteValidate
   c_diagnostic_message_->SetValue(message);
 }
 
+void DiagnosticPanel::ClearDiagnostic() {
+  c_diagnostic_message_->Clear();
+  appended_hazard_count_ = 0;
+}
+
+void DiagnosticPanel::AppendHazards(const std::vector<entities::diagnostic::DiagnosticHazardPoint>& hazard_points) {
+  // the rest is counted by the complete diagnostic
+  for (const auto& point : hazard_points) {
+    if (appended_hazard_count_ >= entities::diagnostic::kMaxListedHazards) {
+      break;
+    }
+    c_diagnostic_message_->AppendText(point.GetMessage() + '\n');
+    ++appended_hazard_count_;
+  }
+}
+
+void DiagnosticPanel::UpdateSummary(const std::vector<entities::diagnostic::RouteValidateSummary>& summaries) {
+  // the table is aligned with spaces
+  c_diagnostic_message_->SetFont(wxFont(wxFontInfo().Family(wxFONTFAMILY_TELETYPE)));
+  c_diagnostic_message_->SetValue(entities::diagnostic::GetSummaryTable(summaries));
+}
+
+void DiagnosticPanel::UpdateFeasibility(const entities::diagnostic::FeasibilityMatrix& matrix) {
+  // the table is aligned with spaces
+  c_diagnostic_message_->SetFont(wxFont(wxFontInfo().Family(wxFONTFAMILY_TELETYPE)));
+  c_diagnostic_message_->SetValue(entities::diagnostic::GetFeasibilityMessage(matrix));
+}
+
+void DiagnosticPanel::UpdateDepartureWindow(const std::vector<entities::diagnostic::DepartureDiagnostic>& departures) {
+  c_diagnostic_message_->SetValue(entities::diagnostic::GetDepartureWindowMessage(departures));
+}
+
 } // namespace marine_navi::dialogs::panels
@@ -12,9 +12,16 @@ public:
   DiagnosticPanel(wxWindow* parent);
 
   void UpdateDiagnostic(const entities::diagnostic::RouteValidateDiagnostic& diagnostic);
+  void ClearDiagnostic();
+  // hazards streamed while the route is scanned
+  void AppendHazards(const std::vector<entities::diagnostic::DiagnosticHazardPoint>& hazard_points);
+  void UpdateSummary(const std::vector<entities::diagnostic::RouteValidateSummary>& summaries);
+  void UpdateDepartureWindow(const std::vector<entities::diagnostic::DepartureDiagnostic>& departures);
+  void UpdateFeasibility(const entities::diagnostic::FeasibilityMatrix& matrix);
 
 private:
   wxTextCtrl* c_diagnostic_message_;
+  size_t appended_hazard_count_;
 };
 
 } // namespace marine_navi::dialogs::panels
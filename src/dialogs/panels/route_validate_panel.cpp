@@ -17,6 +17,20 @@ namespace marine_navi::dialogs::panels {
 
 namespace {
 
+// departures over the next two days from the selected departure time
+constexpr time_t kDepartureWindow = 48 * 60 * 60;
+constexpr time_t kDepartureStep = 60 * 60;
+// ship parameters are swept by these factors of the entered values
+const std::vector<double> kSweepFactors = {0.6, 0.8, 1.0, 1.2, 1.4};
+
+std::vector<double> ScaleValues(double value, const std::vector<double>& factors) {
+  std::vector<double> result;
+  for (const double factor : factors) {
+    result.push_back(value * factor);
+  }
+  return result;
+}
+
 wxArrayString GetRouteNames() {
   wxArrayString result;
   wxArrayString routeGUIDArray = GetRouteGUIDArray();
@@ -43,6 +57,26 @@ std::vector<PlugIn_Waypoint> GetRoute(wxString route_name) {
   return result;
 }
 
+std::vector<std::pair<std::string, std::vector<PlugIn_Waypoint>>> GetAllRoutes() {
+  std::vector<std::pair<std::string, std::vector<PlugIn_Waypoint>>> result;
+  wxArrayString routeGUIDArray = GetRouteGUIDArray();
+  for (const auto& routeGUID : routeGUIDArray) {
+    std::unique_ptr<PlugIn_Route> route = GetRoute_Plugin(routeGUID);
+    // the route may be deleted after the GUIDs are taken
+    if (route == nullptr) {
+      continue;
+    }
+    std::vector<PlugIn_Waypoint> waypoints;
+    auto* node = route->pWaypointList->GetFirst();
+    while (node) {
+      waypoints.push_back(*(node->GetData()));
+      node = node->GetNext();
+    }
+    result.emplace_back(route->m_NameString.ToStdString(), std::move(waypoints));
+  }
+  return result;
+}
+
 void RefreshRouteList(wxListBox* boxList) {
   boxList->Clear();
   boxList->InsertItems(GetRouteNames(), 0);
@@ -143,8 +177,16 @@ void RouteValidatePanel::CreateControls() {
   mainSizer->Add(splitter, 1, wxALL | wxEXPAND, 5);
 
   b_scan_route_ = new wxButton(this, wxID_ANY, _("Check path"));
+  b_scan_all_routes_ = new wxButton(this, wxID_ANY, _("Check all routes"));
+  b_scan_departure_window_ = new wxButton(this, wxID_ANY, _("Find departure window"));
+  b_sweep_ship_parameters_ = new wxButton(this, wxID_ANY, _("Sweep ship parameters"));
+  c_monitor_route_ = new wxCheckBox(this, wxID_ANY, _("Monitor from own ship position"));
   b_load_forecasts_ = new wxButton(this, wxID_ANY, _("Download forecasts"));
   mainSizer->Add(b_scan_route_, 0, wxALL | wxEXPAND, 5);
+  mainSizer->Add(b_scan_all_routes_, 0, wxALL | wxEXPAND, 5);
+  mainSizer->Add(b_scan_departure_window_, 0, wxALL | wxEXPAND, 5);
+  mainSizer->Add(b_sweep_ship_parameters_, 0, wxALL | wxEXPAND, 5);
+  mainSizer->Add(c_monitor_route_, 0, wxALL | wxEXPAND, 5);
   mainSizer->Add(b_load_forecasts_, 0, wxALL | wxEXPAND, 5);
 
   SetSizerAndFit(mainSizer);
@@ -154,6 +196,14 @@ void RouteValidatePanel::CreateControls() {
 void RouteValidatePanel::BindEvents() {
   b_scan_route_->Bind(wxEVT_BUTTON, &RouteValidatePanel::OnCheckPathClicked,
                     this);
+  b_scan_all_routes_->Bind(wxEVT_BUTTON, &RouteValidatePanel::OnCheckAllRoutesClicked,
+                           this);
+  b_scan_departure_window_->Bind(wxEVT_BUTTON, &RouteValidatePanel::OnDepartureWindowClicked,
+                                 this);
+  b_sweep_ship_parameters_->Bind(wxEVT_BUTTON, &RouteValidatePanel::OnSweepShipParametersClicked,
+                                 this);
+  c_monitor_route_->Bind(wxEVT_CHECKBOX, &RouteValidatePanel::OnMonitorRouteToggled,
+                         this);
   b_load_depth_->Bind(wxEVT_BUTTON, &RouteValidatePanel::OnLoadDepthClicked, this);
   b_load_forecasts_->Bind(wxEVT_BUTTON,
                         &RouteValidatePanel::OnLoadForecastsClicked, this);
@@ -166,6 +216,14 @@ void RouteValidatePanel::BindEvents() {
 void RouteValidatePanel::UnbindEvents() {
   b_scan_route_->Unbind(wxEVT_BUTTON, &RouteValidatePanel::OnCheckPathClicked,
                       this);
+  b_scan_all_routes_->Unbind(wxEVT_BUTTON, &RouteValidatePanel::OnCheckAllRoutesClicked,
+                             this);
+  b_scan_departure_window_->Unbind(wxEVT_BUTTON, &RouteValidatePanel::OnDepartureWindowClicked,
+                                   this);
+  b_sweep_ship_parameters_->Unbind(wxEVT_BUTTON, &RouteValidatePanel::OnSweepShipParametersClicked,
+                                   this);
+  c_monitor_route_->Unbind(wxEVT_CHECKBOX, &RouteValidatePanel::OnMonitorRouteToggled,
+                           this);
   b_load_depth_->Unbind(wxEVT_BUTTON,
                         &RouteValidatePanel::OnLoadDepthClicked, this);
   b_load_forecasts_->Unbind(wxEVT_BUTTON,
@@ -176,34 +234,219 @@ void RouteValidatePanel::UnbindEvents() {
                              &RouteValidatePanel::OnRefreshRouteList, this);
 }
 
-void RouteValidatePanel::OnCheckPathClicked(wxCommandEvent&) {
+std::optional<cases::RouteScannerInput> RouteValidatePanel::GetRouteScannerInput() {
   cases::RouteScannerInput route_data;
 
   if (int selection = route_list_box_->GetSelection(); selection == wxNOT_FOUND) {
     wxMessageBox("Please choose a route.", "Error", wxOK | wxICON_ERROR);
-    return;
+    return std::nullopt;
   } else {
     route_data.Route = std::make_shared<entities::Route>(
         entities::Route(GetRoute(route_list_box_->GetString(selection))));
     if (route_data.Route->GetSegments().size() < 1) {
       wxMessageBox("Invalid route.", "Error", wxOK | wxICON_ERROR);
-      return;
+      return std::nullopt;
     }
   }
 
   route_data.ShipPerformanceInfo = ship_info_panel_->GetShipInfo();
   if (!route_data.ShipPerformanceInfo.Speed.has_value()) {
-    return;
+    return std::nullopt;
   }
   route_data.DepartTime = GetTimeFromCtrls(d_route_date_, t_route_time_);
+  return route_data;
+}
+
+void RouteValidatePanel::OnCheckPathClicked(wxCommandEvent&) {
+  const auto route_data = GetRouteScannerInput();
+  if (!route_data.has_value()) {
+    return;
+  }
 
-  marine_route_scanner_->SetPathData(route_data);
+  marine_route_scanner_->SetPathData(route_data.value());
   marine_route_scanner_->SetShow(true);
-  marine_route_scanner_->CrossDetect();
-  const auto diagnostic = marine_route_scanner_->GetDiagnostic();
+  b_scan_route_->Disable();
+  diagnostic_panel_->ClearDiagnostic();
+  marine_route_scanner_->CrossDetectAsync(
+      [this, alive = alive_](std::optional<entities::diagnostic::RouteValidateDiagnostic> diagnostic) {
+        wxTheApp->CallAfter([this, alive, diagnostic = std::move(diagnostic)] {
+          if (*alive) {
+            OnCrossDetectFinished(diagnostic);
+          }
+        });
+      },
+      [this, alive = alive_](std::vector<entities::diagnostic::DiagnosticHazardPoint> hazard_points) {
+        wxTheApp->CallAfter([this, alive, hazard_points = std::move(hazard_points)] {
+          if (*alive) {
+            OnHazardsFound(hazard_points);
+          }
+        });
+      });
+}
+
+void RouteValidatePanel::OnHazardsFound(
+    const std::vector<entities::diagnostic::DiagnosticHazardPoint>& hazard_points) {
+  diagnostic_panel_->AppendHazards(hazard_points);
+  // the overlay adds the hazards published with the snapshot
+  RequestRefresh(canvas_window_);
+}
+
+void RouteValidatePanel::OnCrossDetectFinished(
+    const std::optional<entities::diagnostic::RouteValidateDiagnostic>& diagnostic) {
+  b_scan_route_->Enable();
+  if (diagnostic.has_value()) {
+    diagnostic_panel_->UpdateDiagnostic(diagnostic.value());
+  } else {
+    wxMessageBox("Failed to check the route.", "Error", wxOK | wxICON_ERROR);
+  }
+
+  RequestRefresh(canvas_window_);
+}
+
+void RouteValidatePanel::OnCheckAllRoutesClicked(wxCommandEvent&) {
+  const auto ship = ship_info_panel_->GetShipInfo();
+  if (!ship.Speed.has_value()) {
+    return;
+  }
+
+  std::vector<std::string> route_names;
+  std::vector<std::shared_ptr<entities::Route>> routes;
+  for (auto& [name, waypoints] : GetAllRoutes()) {
+    auto route = std::make_shared<entities::Route>(entities::Route(std::move(waypoints)));
+    if (route->GetSegments().empty()) {
+      continue;
+    }
+    route_names.push_back(name);
+    routes.push_back(std::move(route));
+  }
+  if (routes.empty()) {
+    wxMessageBox("There are no routes.", "Error", wxOK | wxICON_ERROR);
+    return;
+  }
+
+  b_scan_all_routes_->Disable();
+  marine_route_scanner_->CrossDetectFleetAsync(
+      std::move(routes), ship, GetTimeFromCtrls(d_route_date_, t_route_time_),
+      [this, alive = alive_, route_names](
+          std::vector<std::optional<entities::diagnostic::RouteValidateDiagnostic>> diagnostics) {
+        wxTheApp->CallAfter([this, alive, route_names, diagnostics = std::move(diagnostics)] {
+          if (*alive) {
+            OnFleetDetectFinished(route_names, diagnostics);
+          }
+        });
+      });
+}
+
+void RouteValidatePanel::OnFleetDetectFinished(
+    const std::vector<std::string>& route_names,
+    const std::vector<std::optional<entities::diagnostic::RouteValidateDiagnostic>>& diagnostics) {
+  b_scan_all_routes_->Enable();
+
+  std::vector<entities::diagnostic::RouteValidateSummary> summaries;
+  for (size_t i = 0; i < route_names.size(); ++i) {
+    summaries.push_back(entities::diagnostic::RouteValidateSummary{
+      .route_name = route_names[i],
+      .diagnostic = diagnostics[i],
+    });
+  }
+  diagnostic_panel_->UpdateSummary(summaries);
+}
+
+void RouteValidatePanel::OnDepartureWindowClicked(wxCommandEvent&) {
+  const auto route_data = GetRouteScannerInput();
+  if (!route_data.has_value()) {
+    return;
+  }
+
+  const time_t from = route_data->DepartTime;
+  b_scan_departure_window_->Disable();
+  marine_route_scanner_->ScanDepartureWindowAsync(
+      route_data.value(), from, from + kDepartureWindow, kDepartureStep,
+      [this, alive = alive_](std::optional<std::vector<entities::diagnostic::DepartureDiagnostic>> departures) {
+        wxTheApp->CallAfter([this, alive, departures = std::move(departures)] {
+          if (*alive) {
+            OnDepartureWindowFinished(departures);
+          }
+        });
+      });
+}
+
+void RouteValidatePanel::OnDepartureWindowFinished(
+    const std::optional<std::vector<entities::diagnostic::DepartureDiagnostic>>& departures) {
+  b_scan_departure_window_->Enable();
+  if (departures.has_value()) {
+    diagnostic_panel_->UpdateDepartureWindow(departures.value());
+  } else {
+    wxMessageBox("Failed to scan the departure window.", "Error", wxOK | wxICON_ERROR);
+  }
+}
+
+void RouteValidatePanel::OnSweepShipParametersClicked(wxCommandEvent&) {
+  const auto route_data = GetRouteScannerInput();
+  if (!route_data.has_value()) {
+    return;
+  }
+  const auto& ship = route_data->ShipPerformanceInfo;
+  if (!ship.ShipDraft.has_value() || !ship.DangerHeight.has_value()) {
+    wxMessageBox("Please enter ship draft and danger height.", "Error", wxOK | wxICON_ERROR);
+    return;
+  }
+
+  auto grid = cases::ShipParametersGrid{
+    .drafts = ScaleValues(ship.ShipDraft.value(), kSweepFactors),
+    .speeds = ScaleValues(ship.Speed.value(), kSweepFactors),
+    .danger_heights = ScaleValues(ship.DangerHeight.value(), kSweepFactors),
+  };
+  b_sweep_ship_parameters_->Disable();
+  marine_route_scanner_->SweepShipParametersAsync(
+      route_data.value(), std::move(grid),
+      [this, alive = alive_](std::optional<entities::diagnostic::FeasibilityMatrix> matrix) {
+        wxTheApp->CallAfter([this, alive, matrix = std::move(matrix)] {
+          if (*alive) {
+            OnSweepShipParametersFinished(matrix);
+          }
+        });
+      });
+}
+
+void RouteValidatePanel::OnSweepShipParametersFinished(
+    const std::optional<entities::diagnostic::FeasibilityMatrix>& matrix) {
+  b_sweep_ship_parameters_->Enable();
+  if (matrix.has_value()) {
+    diagnostic_panel_->UpdateFeasibility(matrix.value());
+  } else {
+    wxMessageBox("Failed to sweep ship parameters.", "Error", wxOK | wxICON_ERROR);
+  }
+}
+
+void RouteValidatePanel::OnMonitorRouteToggled(wxCommandEvent&) {
+  if (!c_monitor_route_->GetValue()) {
+    marine_route_scanner_->StopMonitoring();
+    return;
+  }
+
+  const auto route_data = GetRouteScannerInput();
+  if (!route_data.has_value()) {
+    c_monitor_route_->SetValue(false);
+    return;
+  }
+
+  marine_route_scanner_->SetPathData(route_data.value());
+  marine_route_scanner_->SetShow(true);
+  marine_route_scanner_->StartMonitoring(
+      [this, alive = alive_](std::optional<entities::diagnostic::RouteValidateDiagnostic> diagnostic) {
+        wxTheApp->CallAfter([this, alive, diagnostic = std::move(diagnostic)] {
+          if (*alive) {
+            OnMonitorUpdated(diagnostic);
+          }
+        });
+      });
+}
+
+void RouteValidatePanel::OnMonitorUpdated(
+    const std::optional<entities::diagnostic::RouteValidateDiagnostic>& diagnostic) {
   if (diagnostic.has_value()) {
-    fprintf(stderr, "Before call\n");
-    diagnostic_panel_->UpdateDiagnostic(diagnostic.value());  // TODO remove reinterpret_cast
+    diagnostic_panel_->UpdateDiagnostic(diagnostic.value());
   }
 
   RequestRefresh(canvas_window_);
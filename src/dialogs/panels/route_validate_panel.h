@@ -7,6 +7,7 @@
 #include <wx/timectrl.h>
 #include <wx/wx.h>
 
+#include "cases/marine_route_scanner.h"
 #include "dialogs/panels/diagnostic_panel.h"
 #include "dialogs/panels/ship_info_panel.h"
 #include "dependencies.h"
@@ -17,14 +18,31 @@ class RouteValidatePanel : public wxPanel {
 public:
   RouteValidatePanel(wxWindow* parent, DiagnosticPanel* diagnostic_panel,
                       const Dependencies& dependencies);
-  ~RouteValidatePanel() override { UnbindEvents(); }
+  ~RouteValidatePanel() override {
+    *alive_ = false;
+    marine_route_scanner_->StopMonitoring();
+    UnbindEvents();
+  }
 
 private:
   void CreateControls();
 
   void BindEvents();
   void UnbindEvents();
+  std::optional<cases::RouteScannerInput> GetRouteScannerInput();
   void OnCheckPathClicked(wxCommandEvent&);
+  void OnHazardsFound(const std::vector<entities::diagnostic::DiagnosticHazardPoint>& hazard_points);
+  void OnCrossDetectFinished(const std::optional<entities::diagnostic::RouteValidateDiagnostic>& diagnostic);
+  void OnCheckAllRoutesClicked(wxCommandEvent&);
+  void OnFleetDetectFinished(const std::vector<std::string>& route_names,
+                             const std::vector<std::optional<entities::diagnostic::RouteValidateDiagnostic>>& diagnostics);
+  void OnDepartureWindowClicked(wxCommandEvent&);
+  void OnDepartureWindowFinished(
+      const std::optional<std::vector<entities::diagnostic::DepartureDiagnostic>>& departures);
+  void OnSweepShipParametersClicked(wxCommandEvent&);
+  void OnSweepShipParametersFinished(const std::optional<entities::diagnostic::FeasibilityMatrix>& matrix);
+  void OnMonitorRouteToggled(wxCommandEvent&);
+  void OnMonitorUpdated(const std::optional<entities::diagnostic::RouteValidateDiagnostic>& diagnostic);
   void OnLoadDepthClicked(wxCommandEvent&);
   void OnLoadForecastsClicked(wxCommandEvent&);
   void OnBrowseDepthClicked(wxCommandEvent&);
@@ -44,12 +62,19 @@ private:
   wxDatePickerCtrl* d_route_date_;
   wxTimePickerCtrl* t_route_time_;
   wxTextCtrl* c_depth_file_;
+  wxCheckBox* c_monitor_route_;
 
   wxButton* b_browse_depth_file_button_;
   wxButton* b_scan_route_;
+  wxButton* b_scan_all_routes_;
+  wxButton* b_scan_departure_window_;
+  wxButton* b_sweep_ship_parameters_;
   wxButton* b_load_forecasts_;
   wxButton* b_refresh_route_list_;
   wxButton* b_load_depth_;
+
+  // detection results are delivered after the panel may be destroyed
+  std::shared_ptr<bool> alive_ = std::make_shared<bool>(true);
 };
 
 
@@ -0,0 +1,176 @@
+#include "danger_distance_field.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "common/utils.h"
+
+namespace marine_navi::entities {
+
+namespace {
+
+constexpr double kInf = std::numeric_limits<double>::infinity();
+// 2: columns are spaced as at the poleward edge of the raster
+const int64_t kFileVersion = 2;
+
+template <typename T>
+void WriteValue(std::ostream& out, const T& value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+void ReadValue(std::istream& in, T& value) {
+  if (!in.read(reinterpret_cast<char*>(&value), sizeof(value))) {
+    throw std::runtime_error("unexpected end of distance field file");
+  }
+}
+
+// One dimensional squared distance transform of f sampled with spacing in meters,
+// lower envelope of parabolas rooted at the finite values of f.
+void DistanceTransform1D(const std::vector<double>& f, double spacing,
+                         std::vector<double>& d, std::vector<size_t>& v, std::vector<double>& z) {
+  const size_t n = f.size();
+  size_t k = 0;
+  bool has_parabola = false;
+  for (size_t q = 0; q < n; ++q) {
+    if (f[q] == kInf) {
+      continue;
+    }
+    const double xq = q * spacing;
+    if (!has_parabola) {
+      v[0] = q;
+      z[0] = -kInf;
+      z[1] = kInf;
+      has_parabola = true;
+      continue;
+    }
+    double s;
+    while (true) {
+      const double xv = v[k] * spacing;
+      s = ((f[q] + xq * xq) - (f[v[k]] + xv * xv)) / (2 * (xq - xv));
+      if (s > z[k]) {
+        break;
+      }
+      --k;  // z[0] is -inf, so the first parabola is never removed
+    }
+    ++k;
+    v[k] = q;
+    z[k] = s;
+    z[k + 1] = kInf;
+  }
+
+  if (!has_parabola) {
+    std::fill(d.begin(), d.end(), kInf);
+    return;
+  }
+  k = 0;
+  for (size_t q = 0; q < n; ++q) {
+    const double xq = q * spacing;
+    while (z[k + 1] < xq) {
+      ++k;
+    }
+    const double xv = v[k] * spacing;
+    d[q] = (xq - xv) * (xq - xv) + f[v[k]];
+  }
+}
+
+}  // namespace
+
+DangerDistanceField::DangerDistanceField(RasterGeometry geometry, double draft)
+    : geometry_(geometry), draft_(draft) {}
+
+DangerDistanceField DangerDistanceField::Build(const ShallowMask& mask, common::ThreadPool& pool) {
+  const auto& geometry = mask.GetGeometry();
+  const size_t n_rows = geometry.n_rows;
+  const size_t n_cols = geometry.n_cols;
+  // columns converge to the pole, the narrowest spacing of the raster never overstates a distance
+  const double max_lat = std::max(std::abs(geometry.min_lat), std::abs(geometry.GetMaxLat()));
+  const double row_spacing = geometry.cell_size * common::kMetersPerDegree;
+  const double col_spacing = row_spacing * std::cos(std::min(max_lat, 90.0) * M_PI / 180);
+
+  // squared distances along columns first, then along rows
+  std::vector<double> squared(n_rows * n_cols);
+  common::ParallelFor(pool, n_cols, [&](size_t begin, size_t end) {
+    std::vector<double> f(n_rows), d(n_rows), z(n_rows + 1);
+    std::vector<size_t> v(n_rows);
+    for (size_t col = begin; col < end; ++col) {
+      for (size_t row = 0; row < n_rows; ++row) {
+        f[row] = mask.IsShallow(row, col) ? 0 : kInf;
+      }
+      DistanceTransform1D(f, row_spacing, d, v, z);
+      for (size_t row = 0; row < n_rows; ++row) {
+        squared[row * n_cols + col] = d[row];
+      }
+    }
+  });
+
+  DangerDistanceField result(geometry, mask.GetDraft());
+  result.distances_.resize(n_rows * n_cols);
+  common::ParallelFor(pool, n_rows, [&](size_t begin, size_t end) {
+    std::vector<double> f(n_cols), d(n_cols), z(n_cols + 1);
+    std::vector<size_t> v(n_cols);
+    for (size_t row = begin; row < end; ++row) {
+      std::copy(squared.begin() + row * n_cols, squared.begin() + (row + 1) * n_cols, f.begin());
+      DistanceTransform1D(f, col_spacing, d, v, z);
+      for (size_t col = 0; col < n_cols; ++col) {
+        result.distances_[row * n_cols + col] = static_cast<float>(std::sqrt(d[col]));
+      }
+    }
+  });
+  return result;
+}
+
+std::optional<double> DangerDistanceField::GetDistance(common::Point point) const {
+  const auto cell = geometry_.GetCell(point);
+  if (!cell.has_value()) {
+    return std::nullopt;
+  }
+  return GetDistance(cell->first, cell->second);
+}
+
+double DangerDistanceField::GetCellDiagonal() const {
+  return geometry_.cell_size * common::kMetersPerDegree * std::sqrt(2.0);
+}
+
+void DangerDistanceField::Save(std::ostream& out) const {
+  WriteValue(out, kFileVersion);
+  WriteValue(out, geometry_.min_lat);
+  WriteValue(out, geometry_.min_lon);
+  WriteValue(out, geometry_.cell_size);
+  WriteValue(out, geometry_.n_rows);
+  WriteValue(out, geometry_.n_cols);
+  WriteValue(out, draft_);
+  out.write(reinterpret_cast<const char*>(distances_.data()), distances_.size() * sizeof(float));
+}
+
+DangerDistanceField DangerDistanceField::Load(std::istream& in) {
+  int64_t version;
+  ReadValue(in, version);
+  if (version != kFileVersion) {
+    throw std::runtime_error("unsupported distance field file version");
+  }
+  RasterGeometry geometry;
+  double draft;
+  ReadValue(in, geometry.min_lat);
+  ReadValue(in, geometry.min_lon);
+  ReadValue(in, geometry.cell_size);
+  ReadValue(in, geometry.n_rows);
+  ReadValue(in, geometry.n_cols);
+  ReadValue(in, draft);
+
+  // sizes are read from the file, so a damaged one is rejected before the distances are allocated
+  const size_t cell_count = static_cast<size_t>(geometry.n_rows) * geometry.n_cols;
+  if (common::GetRemainingSize(in) != cell_count * sizeof(float)) {
+    throw std::runtime_error("distance field file size does not match its geometry");
+  }
+  DangerDistanceField field(geometry, draft);
+  field.distances_.resize(cell_count);
+  if (!in.read(reinterpret_cast<char*>(field.distances_.data()), field.distances_.size() * sizeof(float))) {
+    throw std::runtime_error("unexpected end of distance field file");
+  }
+  return field;
+}
+
+}  // namespace marine_navi::entities
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <vector>
+
+#include "common/thread_pool.h"
+#include "entities/shallow_mask.h"
+
+namespace marine_navi::entities {
+
+// Distance in meters from every raster cell to the closest shallow cell of the mask, a lower bound of the
+// distance on the sphere
+class DangerDistanceField {
+public:
+  // Euclidean distance transform (Felzenszwalb, Huttenlocher) with the column spacing at the poleward edge of
+  // the raster, columns and rows are processed in parallel
+  static DangerDistanceField Build(const ShallowMask& mask, common::ThreadPool& pool);
+
+  // @return distance in meters, std::nullopt if point is outside of raster. Infinity if there are no shallow cells
+  std::optional<double> GetDistance(common::Point point) const;
+  double GetDistance(uint32_t row, uint32_t col) const { return distances_[row * geometry_.n_cols + col]; }
+  // @return diagonal of raster cell in meters, the precision of distances
+  double GetCellDiagonal() const;
+
+  const RasterGeometry& GetGeometry() const { return geometry_; }
+  double GetDraft() const { return draft_; }
+
+  void Save(std::ostream& out) const;
+  static DangerDistanceField Load(std::istream& in);
+
+private:
+  DangerDistanceField(RasterGeometry geometry, double draft);
+
+private:
+  RasterGeometry geometry_;
+  double draft_;
+  std::vector<float> distances_;
+};
+
+}  // namespace marine_navi::entities
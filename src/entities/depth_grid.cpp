@@ -92,4 +92,18 @@ std::vector<entities::DepthPoint> DepthGrid::GetAllPoints() const {
   return result;
 }
 
+double DepthGrid::GetSampleDepth(uint32_t row, uint32_t col) const {
+  return static_cast<double>(data_[data_.size() - row - 1][col]);
+}
+
+RasterGeometry DepthGrid::GetGeometry() const {
+  return RasterGeometry{
+    .min_lat = minLat_,
+    .min_lon = minLon_,
+    .cell_size = cellSize_,
+    .n_rows = nRows_,
+    .n_cols = nCols_,
+  };
+}
+
 }  // namespace marine_navi::entities
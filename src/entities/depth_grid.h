@@ -8,9 +8,15 @@
 #include "common/geom.h"
 #include "common/utils.h"
 #include "entities/depth_point.h"
+#include "entities/raster_geometry.h"
 
 namespace marine_navi::entities {
 
+struct DepthGridInfo {
+  int64_t id;
+  RasterGeometry geometry;
+};
+
 class DepthGrid {
 public:
   DepthGrid(std::string filepath);
@@ -20,6 +26,9 @@ public:
   std::optional<entities::DepthPoint> GetNearestDepthPoint(const common::Point point) const;
 
   std::vector<entities::DepthPoint> GetAllPoints() const;
+  // row is counted from the south edge, the same as in GetAllPoints
+  double GetSampleDepth(uint32_t row, uint32_t col) const;
+  RasterGeometry GetGeometry() const;
 
 private:
   uint32_t nCols_;
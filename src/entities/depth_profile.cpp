@@ -0,0 +1,35 @@
+#include "depth_profile.h"
+
+#include <algorithm>
+
+namespace marine_navi::entities {
+
+namespace {
+
+// depths are negative below the sea level
+double GetWaterDepth(const DepthProfile::Tile& tile) {
+  return -tile.shallowest_point->Depth;
+}
+
+}  // namespace
+
+DepthProfile::DepthProfile(std::vector<Tile> tiles) : tiles_(std::move(tiles)) {
+  for (size_t i = 0; i < tiles_.size(); ++i) {
+    if (tiles_[i].shallowest_point.has_value()) {
+      tiles_by_depth_.push_back(i);
+    }
+  }
+  std::sort(tiles_by_depth_.begin(), tiles_by_depth_.end(), [this](size_t lhs, size_t rhs) {
+    return GetWaterDepth(tiles_[lhs]) < GetWaterDepth(tiles_[rhs]);
+  });
+}
+
+std::vector<size_t> DepthProfile::FindShallowTiles(double required_depth) const {
+  const auto end = std::upper_bound(tiles_by_depth_.begin(), tiles_by_depth_.end(), required_depth,
+    [this](double value, size_t tile_id) { return value < GetWaterDepth(tiles_[tile_id]); });
+  std::vector<size_t> result(tiles_by_depth_.begin(), end);
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+}  // namespace marine_navi::entities
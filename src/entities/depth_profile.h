@@ -0,0 +1,34 @@
+#pragma once
+
+#include <optional>
+#include <vector>
+
+#include "entities/depth_point.h"
+
+namespace marine_navi::entities {
+
+// Shallowest depth point of every corridor tile along a route. It does not depend on the draft,
+// so one profile checks any draft, squat allowance or tide offset without queries.
+class DepthProfile {
+public:
+  struct Tile {
+    size_t segment_id;
+    // std::nullopt if there are no depth points in the tile
+    std::optional<DepthPoint> shallowest_point;
+  };
+
+  // tiles are in route order
+  explicit DepthProfile(std::vector<Tile> tiles);
+
+  // @return ids of tiles in route order where water is not deeper than required_depth, which is the draft
+  // with squat allowance less the tide offset. O(log n + k log k) for k found tiles
+  std::vector<size_t> FindShallowTiles(double required_depth) const;
+  const std::vector<Tile>& GetTiles() const { return tiles_; }
+
+private:
+  std::vector<Tile> tiles_;
+  // ids of tiles with depth points by increasing water depth
+  std::vector<size_t> tiles_by_depth_;
+};
+
+}  // namespace marine_navi::entities
@@ -1,6 +1,8 @@
 
 #include "diagnostic.h"
 
+#include <algorithm>
+
 namespace marine_navi::entities::diagnostic {
 
 namespace {
@@ -14,9 +16,99 @@ std::string GetDiagnosticMessage(const RouteValidateDiagnostic& diagnostic) {
     return "OK";
   }
 
+  const auto& hazard_points = diagnostic.hazard_points;
+  const size_t listed_count = std::min(hazard_points.size(), kMaxListedHazards);
   std::stringstream ss;
-  for(const auto& point : diagnostic.hazard_points) {
-    ss << point.GetMessage() << '\n';
+  for(size_t i = 0; i < listed_count; ++i) {
+    ss << hazard_points[i].GetMessage() << '\n';
+  }
+  if (listed_count < hazard_points.size()) {
+    ss << common::StringFormat("... and %zu more hazards\n", hazard_points.size() - listed_count);
+  }
+
+  return ss.str();
+}
+
+std::string GetSummaryTable(const std::vector<RouteValidateSummary>& summaries) {
+  const std::string kRowFormat = "%-32s %-8s %8s  %s\n";
+
+  std::stringstream ss;
+  ss << common::StringFormat(kRowFormat, "Route", "Result", "Hazards", "First hazard at");
+  for (const auto& summary : summaries) {
+    const auto& name = summary.route_name;
+    if (!summary.diagnostic.has_value()) {
+      ss << common::StringFormat(kRowFormat, name.c_str(), "FAILED", "-", "-");
+      continue;
+    }
+
+    const auto& hazard_points = summary.diagnostic->hazard_points;
+    if (summary.diagnostic->result == RouteValidateDiagnostic::DiagnosticResultType::kOk || hazard_points.empty()) {
+      ss << common::StringFormat(kRowFormat, name.c_str(), "OK", "0", "-");
+      continue;
+    }
+    const auto first_hazard = std::min_element(hazard_points.begin(), hazard_points.end(),
+      [](const DiagnosticHazardPoint& lhs, const DiagnosticHazardPoint& rhs) {
+        return lhs.GetExpectedTime() < rhs.GetExpectedTime();
+      });
+    ss << common::StringFormat(kRowFormat, name.c_str(), "WARNING",
+                               std::to_string(hazard_points.size()).c_str(),
+                               common::ToString(first_hazard->GetExpectedTime()).c_str());
+  }
+
+  return ss.str();
+}
+
+std::string GetDepartureWindowMessage(const std::vector<DepartureDiagnostic>& departures) {
+  std::stringstream ss;
+  for (const auto& departure : departures) {
+    ss << common::ToString(departure.depart_time, "%Y-%m-%d %H:%M");
+    if (departure.limiting_hazard.has_value()) {
+      ss << "  NO-GO  " << departure.limiting_hazard->GetMessage() << '\n';
+    } else if (!departure.forecast_covers_passage) {
+      ss << "  UNKNOWN  no forecast for the end of the passage\n";
+    } else {
+      ss << "  GO\n";
+    }
+  }
+
+  return ss.str();
+}
+
+std::string GetFeasibilityMessage(const FeasibilityMatrix& matrix) {
+  const std::string kCellFormat = "%12s";
+
+  std::stringstream ss;
+  for (size_t k = 0; k < matrix.danger_heights.size(); ++k) {
+    ss << common::StringFormat("Danger height %.2lf m, cells are depth/wave hazards\n", matrix.danger_heights[k]);
+    ss << common::StringFormat(kCellFormat, "draft\\speed");
+    for (const double speed : matrix.speeds) {
+      ss << common::StringFormat(kCellFormat, common::StringFormat("%.2lf", speed).c_str());
+    }
+    ss << '\n';
+
+    std::optional<double> max_draft;
+    std::optional<double> min_speed;
+    for (size_t i = 0; i < matrix.drafts.size(); ++i) {
+      ss << common::StringFormat(kCellFormat, common::StringFormat("%.2lf", matrix.drafts[i]).c_str());
+      for (size_t j = 0; j < matrix.speeds.size(); ++j) {
+        const auto& cell = matrix.Get(i, j, k);
+        if (cell.IsFeasible()) {
+          ss << common::StringFormat(kCellFormat, "OK");
+          max_draft = std::max(max_draft.value_or(matrix.drafts[i]), matrix.drafts[i]);
+          min_speed = std::min(min_speed.value_or(matrix.speeds[j]), matrix.speeds[j]);
+        } else {
+          ss << common::StringFormat(kCellFormat,
+            common::StringFormat("%zu/%zu", cell.depth_hazard_count, cell.wave_hazard_count).c_str());
+        }
+      }
+      ss << '\n';
+    }
+
+    if (max_draft.has_value()) {
+      ss << common::StringFormat("Max clean draft %.2lf m, min clean speed %.2lf\n\n", max_draft.value(), min_speed.value());
+    } else {
+      ss << "No clean combination\n\n";
+    }
   }
 
   return ss.str();
@@ -1,17 +1,21 @@
 #pragma once
 
 #include <ctime>
+#include <optional>
 #include <sstream>
+#include <string>
 #include <variant>
 
 #include "common/geom.h"
 #include "common/utils.h"
 
 #include "entities/diagnostic/diagnostic_hazard_point.h"
-#include "entities/diagnostic/diagnostic_event.h"
 
 namespace marine_navi::entities::diagnostic {
 
+// hazards beyond this are counted but not listed, so messages are formatted only for listed ones
+constexpr size_t kMaxListedHazards = 1000;
+
 struct RouteValidateDiagnostic {
   enum class DiagnosticResultType {
     kOk,
@@ -22,6 +26,44 @@ struct RouteValidateDiagnostic {
   std::vector<DiagnosticHazardPoint> hazard_points;
 };
 
+// Row of the summary table of a fleet validation
+struct RouteValidateSummary {
+  std::string route_name;
+  std::optional<RouteValidateDiagnostic> diagnostic;  // nullopt if the route could not be checked
+};
+
+// Departure from a departure window scan, it is safe when there is no limiting hazard
+// and forecasts cover the whole passage
+struct DepartureDiagnostic {
+  time_t depart_time;
+  std::optional<DiagnosticHazardPoint> limiting_hazard;
+  // false if the ship arrives after the loaded forecasts end
+  bool forecast_covers_passage;
+};
+
+// Route check results for every combination of swept ship parameters
+struct FeasibilityMatrix {
+  struct Cell {
+    size_t depth_hazard_count;
+    size_t wave_hazard_count;
+
+    bool IsFeasible() const { return depth_hazard_count == 0 && wave_hazard_count == 0; }
+  };
+
+  std::vector<double> drafts;
+  std::vector<double> speeds;
+  std::vector<double> danger_heights;
+  // the danger height index changes fastest, then the speed index
+  std::vector<Cell> cells;
+
+  const Cell& Get(size_t draft_id, size_t speed_id, size_t danger_height_id) const {
+    return cells[(draft_id * speeds.size() + speed_id) * danger_heights.size() + danger_height_id];
+  }
+};
+
 std::string GetDiagnosticMessage(const RouteValidateDiagnostic& diagnostic);
+std::string GetSummaryTable(const std::vector<RouteValidateSummary>& summaries);
+std::string GetDepartureWindowMessage(const std::vector<DepartureDiagnostic>& departures);
+std::string GetFeasibilityMessage(const FeasibilityMatrix& matrix);
 
 }  // namespace marine_navi::entities
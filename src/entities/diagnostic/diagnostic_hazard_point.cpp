@@ -11,22 +11,40 @@ std::string DiagnosticHazardPoint::GetMessage() const {
     ss << "Diagnostic hazard point detected at location (" << location_.Lat << ", " << location_.Lon
                   << ") on " << common::ToString(check_time_)
                   << ", with expected troubles at " << common::ToString(expected_time_of_troubles_)
-                  << ", with reason: " << reason_ << ".";
+                  << ", with reason: " << GetReasonMessage() << ".";
     return ss.str();
 }
 
+std::string DiagnosticHazardPoint::GetReasonMessage() const {
+    switch (reason_) {
+        case HazardReason::kDangerousDepth:
+            return count_ > 1
+                ? common::StringFormat("%u dangerous depths, the worst %lf", count_, value_)
+                : common::StringFormat("dangerous depth %lf", value_);
+        case HazardReason::kHighWaves:
+            return count_ > 1
+                ? common::StringFormat("%u dangerous wave heights, the worst %lf", count_, value_)
+                : common::StringFormat("dangerous wave height %lf", value_);
+    }
+    return "unknown";
+}
 
 DiagnosticHazardPoint MakeDepthHazardPoint(
     common::Point location,
     time_t check_time,
     time_t expected_time_of_troubles,
-    double depth) {
+    double depth,
+    size_t count,
+    std::optional<time_t> last_expected_time) {
 
     return DiagnosticHazardPoint(
         location,
         check_time,
         expected_time_of_troubles,
-        common::StringFormat("dangerous depth %lf", depth)
+        last_expected_time.value_or(expected_time_of_troubles),
+        HazardReason::kDangerousDepth,
+        depth,
+        static_cast<uint32_t>(count)
     );
 }
 
@@ -34,13 +52,18 @@ DiagnosticHazardPoint MakeHighWavesHazardPoint(
     common::Point location,
     time_t check_time,
     time_t expected_time_of_troubles,
-    double wave_height) {
+    double wave_height,
+    size_t count,
+    std::optional<time_t> last_expected_time) {
 
     return DiagnosticHazardPoint(
         location,
         check_time,
         expected_time_of_troubles,
-        common::StringFormat("dangerous wave height %lf", wave_height)
+        last_expected_time.value_or(expected_time_of_troubles),
+        HazardReason::kHighWaves,
+        wave_height,
+        static_cast<uint32_t>(count)
     );
 }
 
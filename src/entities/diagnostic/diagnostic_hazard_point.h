@@ -1,47 +1,81 @@
 #pragma once
 
+#include <cstdint>
+#include <optional>
 #include <string>
 #include <time.h>
+#include <type_traits>
 
 #include "common/geom.h"
 #include "entities/depth_point.h"
-#include "entities/diagnostic/diagnostic_event.h"
 
 namespace marine_navi::entities::diagnostic {
 
-class DiagnosticHazardPoint : public IDiagnosticEvent {
+enum class HazardReason : uint8_t {
+  kDangerousDepth,
+  kHighWaves,
+};
+
+// Compact record of a hazard, the text is formatted only when it is shown
+class DiagnosticHazardPoint {
 public:
   DiagnosticHazardPoint(common::Point location,
                         time_t check_time,
                         time_t expected_time_of_troubles,
-                        std::string reason): 
+                        time_t last_expected_time,
+                        HazardReason reason,
+                        double value,
+                        uint32_t count = 1):
     location_(location),
     check_time_(check_time),
     expected_time_of_troubles_(expected_time_of_troubles),
+    last_expected_time_(last_expected_time),
+    value_(value),
+    count_(count),
     reason_(reason) {
   }
-  std::string GetMessage() const override;
+  std::string GetMessage() const;
+  // @return the reason part of the message
+  std::string GetReasonMessage() const;
   const common::Point GetLocation() const { return location_; }
-
-  ~DiagnosticHazardPoint() = default;
+  time_t GetCheckTime() const { return check_time_; }
+  time_t GetExpectedTime() const { return expected_time_of_troubles_; }
+  // @return expected time of the last merged hazard, the whole cluster is passed after it
+  time_t GetLastExpectedTime() const { return last_expected_time_; }
+  HazardReason GetReason() const { return reason_; }
+  double GetValue() const { return value_; }
+  uint32_t GetCount() const { return count_; }
 
 private:
   common::Point location_;
   time_t check_time_;
-  time_t expected_time_of_troubles_;
-  std::string reason_;
+  time_t expected_time_of_troubles_;  // the earliest of merged hazards
+  time_t last_expected_time_;
+  double value_;  // the worst of merged hazards
+  uint32_t count_;  // number of merged hazards
+  HazardReason reason_;
 };
 
+static_assert(std::is_trivially_copyable_v<DiagnosticHazardPoint>);
+
+// count > 1 makes a point of a cluster of hazards, the value is the worst of them. The last expected time
+// is the expected time of troubles unless it is set
 DiagnosticHazardPoint MakeDepthHazardPoint(
     common::Point location,
     time_t check_time,
     time_t expected_time_of_troubles,
-    double depth);
+    double depth,
+    size_t count = 1,
+    std::optional<time_t> last_expected_time = std::nullopt);
 
+// count > 1 makes a point of a cluster of hazards, the value is the worst of them. The last expected time
+// is the expected time of troubles unless it is set
 DiagnosticHazardPoint MakeHighWavesHazardPoint(
     common::Point location,
     time_t check_time,
     time_t expected_time_of_troubles,
-    double wave_height);
+    double wave_height,
+    size_t count = 1,
+    std::optional<time_t> last_expected_time = std::nullopt);
 
-} // namespace marine_navi::entities::diagnostic
\ No newline at end of file
+} // namespace marine_navi::entities::diagnostic
@@ -1,10 +1,13 @@
 #include "find_route_grid.h"
 
 #include <algorithm>
-#include <map>
+#include <cmath>
+#include <limits>
 #include <stdexcept>
+#include <tuple>
 #include <optional>
 
+#include "common/hash.h"
 #include "common/marine_math.h"
 
 namespace marine_navi::entities {
@@ -42,66 +45,220 @@ bool IsInsidePolygon(const std::vector<IntPoint>& polygon, const IntPoint& p) {
 
   return inside;
 }
+
+const int64_t kMaxCheckCount = 1000000;
+const int64_t kMaxVertexCount = 10000;
+
+std::vector<IntPoint> MakeIntPolygon(const common::Polygon& polygon, double step) {
+  std::vector<IntPoint> int_polygon;
+  for (const auto& point : polygon.Points) {
+    int_polygon.push_back(IntPoint{static_cast<int64_t>(point.X() / step), static_cast<int64_t>(point.Y() / step)});
+  }
+  return int_polygon;
+}
+
+// 2: corridor buffers are widened to the east and west with latitude
+const int64_t kFileVersion = 2;
+// longitudes are not stretched more near the poles
+const double kMinLonScale = 0.01;
+
+// @return length in meters of a degree of longitude relative to a degree of latitude, the smallest one
+// along the segment, so buffers of the segment are never narrower than requested
+double GetLonScale(const common::Segment& segment) {
+  const double max_lat = std::max(std::abs(segment.Start.Lat), std::abs(segment.End.Lat));
+  return std::max(std::cos(max_lat * M_PI / 180), kMinLonScale);
+}
+
+common::Point ScaleLon(const common::Point& point, double lon_scale) {
+  return common::Point{point.Lat, point.Lon * lon_scale};
+}
+
+bool operator==(const IntPoint& lhs, const IntPoint& rhs) {
+  return lhs.x == rhs.x && lhs.y == rhs.y;
+}
+
+bool operator<(const IntPoint& lhs, const IntPoint& rhs) {
+  return std::tie(lhs.x, lhs.y) < std::tie(rhs.x, rhs.y);
+}
+
+std::vector<IntPoint> MakeCanonicalPolygon(std::vector<IntPoint> polygon) {
+  polygon.erase(std::unique(polygon.begin(), polygon.end()), polygon.end());
+  while (polygon.size() > 1 && polygon.front() == polygon.back()) {
+    polygon.pop_back();
+  }
+  if (polygon.empty()) {
+    return polygon;
+  }
+  std::rotate(polygon.begin(), std::min_element(polygon.begin(), polygon.end()), polygon.end());
+  std::vector<IntPoint> reversed(polygon.rbegin(), polygon.rend() - 1);
+  reversed.insert(reversed.begin(), polygon.front());
+  return std::min(polygon, reversed, [](const auto& lhs, const auto& rhs) {
+    return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+  });
+}
+
+common::Hasher& AddPolygon(common::Hasher& hasher, const common::Polygon& polygon, double step) {
+  hasher.Add(step);
+  for (const auto& point : MakeCanonicalPolygon(MakeIntPolygon(polygon, step))) {
+    hasher.Add(point.x).Add(point.y);
+  }
+  return hasher;
+}
+
+template <typename T>
+void WriteValue(std::ostream& out, const T& value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+void ReadValue(std::istream& in, T& value) {
+  if (!in.read(reinterpret_cast<char*>(&value), sizeof(value))) {
+    throw std::runtime_error("unexpected end of grid file");
+  }
+}
+
 }  // namespace
 
-FindRouteGrid::FindRouteGrid(const common::Polygon& polygon, double step) {
-  const int64_t kMaxCheckCount = 1000000;
-  const int64_t kMaxVertexCount = 10000;
+FindRouteGrid::FindRouteGrid(const common::Polygon& polygon, double step)
+    : step_(step) {
   int64_t minX = std::numeric_limits<int64_t>::max(),
           maxX = std::numeric_limits<int64_t>::min();
   int64_t minY = std::numeric_limits<int64_t>::max(),
           maxY = std::numeric_limits<int64_t>::min();
 
-  std::vector<IntPoint> int_polygon;
+  const auto int_polygon = MakeIntPolygon(polygon, step);
 
-  for (const auto& point : polygon.Points) {
-    IntPoint pt{static_cast<int64_t>(point.X() / step), static_cast<int64_t>(point.Y() / step)};
+  for (const auto& pt : int_polygon) {
     minX = std::min(minX, pt.x);
     maxX = std::max(maxX, pt.x);
     minY = std::min(minY, pt.y);
     maxY = std::max(maxY, pt.y);
-    int_polygon.push_back(pt);
   }
 
-  std::map<std::pair<int64_t, int64_t>, int> points_with_id;
-
   if (maxX - minX + 1 > kMaxCheckCount || maxY - minY + 1 > kMaxCheckCount ||
       (maxX - minX + 1) * (maxY - minY + 1) > kMaxVertexCount) {
     throw std::runtime_error("number points for check is too big");
   }
 
+  ResetCells(minX, maxX, minY, maxY);
   for (int64_t x = minX; x <= maxX; x++) {
     for (int64_t y = minY; y <= maxY; y++) {
       IntPoint candidate = {x, y};
       if (IsInsidePolygon(int_polygon, candidate)) {
-        points_with_id[{x, y}] = points_.size();
-        points_.push_back(common::Point{y * step, x * step});
+        cell_ids_[(x - min_x_) * height_ + (y - min_y_)] = 0;
       }
     }
   }
-  adjacency_list_.resize(points_.size());
+  BuildGraph();
+}
 
-  for (const auto& [point, id] : points_with_id) {
-    for (int dx = -1; dx <= 1; dx++) {
-      for (int dy = -1; dy <= 1; dy++) {
-        if (dx == 0 && dy == 0) {
+FindRouteGrid::FindRouteGrid(const common::Polygon& polygon,
+                             const std::vector<common::Segment>& corridor,
+                             double buffer, double step)
+    : step_(step) {
+  const auto int_polygon = MakeIntPolygon(polygon, step);
+  // the buffer is in degrees of latitude, degrees of longitude get shorter with latitude
+  const int64_t int_buffer = static_cast<int64_t>(std::ceil(buffer / step));
+  auto get_int_buffer_x = [&](const common::Segment& segment) {
+    return static_cast<int64_t>(std::ceil(buffer / GetLonScale(segment) / step));
+  };
+
+  int64_t minX = std::numeric_limits<int64_t>::max(),
+          maxX = std::numeric_limits<int64_t>::min();
+  int64_t minY = std::numeric_limits<int64_t>::max(),
+          maxY = std::numeric_limits<int64_t>::min();
+  for (const auto& segment : corridor) {
+    const int64_t int_buffer_x = get_int_buffer_x(segment);
+    for (const auto& point : {segment.Start, segment.End}) {
+      minX = std::min(minX, static_cast<int64_t>(point.X() / step) - int_buffer_x);
+      maxX = std::max(maxX, static_cast<int64_t>(point.X() / step) + int_buffer_x);
+      minY = std::min(minY, static_cast<int64_t>(point.Y() / step) - int_buffer);
+      maxY = std::max(maxY, static_cast<int64_t>(point.Y() / step) + int_buffer);
+    }
+  }
+
+  if (corridor.empty() || maxX - minX + 1 > kMaxCheckCount || maxY - minY + 1 > kMaxCheckCount ||
+      (maxX - minX + 1) * (maxY - minY + 1) > kMaxCheckCount) {
+    throw std::runtime_error("number points for check is too big");
+  }
+
+  ResetCells(minX, maxX, minY, maxY);
+  // only cells around segments are checked, so the work depends on route length instead of area
+  for (const auto& segment : corridor) {
+    const double lon_scale = GetLonScale(segment);
+    const int64_t int_buffer_x = get_int_buffer_x(segment);
+    const common::Segment scaled_segment{ScaleLon(segment.Start, lon_scale), ScaleLon(segment.End, lon_scale)};
+    const int64_t segment_min_x = static_cast<int64_t>(std::min(segment.Start.X(), segment.End.X()) / step) - int_buffer_x;
+    const int64_t segment_max_x = static_cast<int64_t>(std::max(segment.Start.X(), segment.End.X()) / step) + int_buffer_x;
+    const int64_t segment_min_y = static_cast<int64_t>(std::min(segment.Start.Y(), segment.End.Y()) / step) - int_buffer;
+    const int64_t segment_max_y = static_cast<int64_t>(std::max(segment.Start.Y(), segment.End.Y()) / step) + int_buffer;
+    for (int64_t x = segment_min_x; x <= segment_max_x; x++) {
+      for (int64_t y = segment_min_y; y <= segment_max_y; y++) {
+        auto& cell_id = cell_ids_[(x - min_x_) * height_ + (y - min_y_)];
+        if (cell_id == 0) {
           continue;
         }
-        if (points_with_id.find({point.first + dx, point.second + dy}) !=
-            points_with_id.end()) {
-          adjacency_list_[id].push_back(
-              points_with_id[{point.first + dx, point.second + dy}]);
+        const common::Point candidate_point{y * step, x * step};
+        if (common::GetDistanceToSegment(ScaleLon(candidate_point, lon_scale), scaled_segment) <= buffer &&
+            IsInsidePolygon(int_polygon, IntPoint{x, y})) {
+          cell_id = 0;
         }
       }
     }
-    if (points_.size() > kMaxVertexCount) {
-      throw std::runtime_error("number points is too big");
+  }
+  BuildGraph();
+}
+
+void FindRouteGrid::ResetCells(int64_t min_x, int64_t max_x, int64_t min_y, int64_t max_y) {
+  min_x_ = min_x;
+  min_y_ = min_y;
+  width_ = max_x - min_x + 1;
+  height_ = max_y - min_y + 1;
+  cell_ids_.assign(width_ * height_, -1);
+}
+
+void FindRouteGrid::BuildGraph() {
+  for (int64_t x = 0; x < width_; x++) {
+    for (int64_t y = 0; y < height_; y++) {
+      auto& cell_id = cell_ids_[x * height_ + y];
+      if (cell_id != -1) {
+        cell_id = points_.size();
+        points_.push_back(common::Point{(y + min_y_) * step_, (x + min_x_) * step_});
+      }
     }
   }
 
+  if (points_.size() > kMaxVertexCount) {
+    throw std::runtime_error("number points is too big");
+  }
   if (points_.size() == 0) {
     throw std::runtime_error("no points");
   }
+
+  adjacency_list_.resize(points_.size());
+  for (int64_t x = 0; x < width_; x++) {
+    for (int64_t y = 0; y < height_; y++) {
+      const int id = cell_ids_[x * height_ + y];
+      if (id == -1) {
+        continue;
+      }
+      for (int dx = -1; dx <= 1; dx++) {
+        for (int dy = -1; dy <= 1; dy++) {
+          if (dx == 0 && dy == 0) {
+            continue;
+          }
+          const int64_t nx = x + dx;
+          const int64_t ny = y + dy;
+          if (nx < 0 || nx >= width_ || ny < 0 || ny >= height_) {
+            continue;
+          }
+          if (const int adjency_id = cell_ids_[nx * height_ + ny]; adjency_id != -1) {
+            adjacency_list_[id].push_back(adjency_id);
+          }
+        }
+      }
+    }
+  }
 }
 
 std::vector<common::Point> FindRouteGrid::GetAdjencyPoints(int point_id) const {
@@ -125,4 +282,77 @@ int FindRouteGrid::GetClosestPointId(common::Point point) const {
   return result;
 }
 
+size_t FindRouteGrid::GetMemoryUsage() const {
+  size_t result = sizeof(*this) + points_.capacity() * sizeof(common::Point) +
+                  cell_ids_.capacity() * sizeof(int) +
+                  adjacency_list_.capacity() * sizeof(std::vector<int>);
+  for (const auto& adjency_ids : adjacency_list_) {
+    result += adjency_ids.capacity() * sizeof(int);
+  }
+  return result;
+}
+
+void FindRouteGrid::Save(std::ostream& out) const {
+  WriteValue(out, kFileVersion);
+  WriteValue(out, step_);
+  WriteValue(out, min_x_);
+  WriteValue(out, min_y_);
+  WriteValue(out, width_);
+  WriteValue(out, height_);
+  out.write(reinterpret_cast<const char*>(cell_ids_.data()), cell_ids_.size() * sizeof(int));
+}
+
+FindRouteGrid FindRouteGrid::Load(std::istream& in) {
+  int64_t version;
+  ReadValue(in, version);
+  if (version != kFileVersion) {
+    throw std::runtime_error("unsupported grid file version");
+  }
+
+  FindRouteGrid grid;
+  ReadValue(in, grid.step_);
+  ReadValue(in, grid.min_x_);
+  ReadValue(in, grid.min_y_);
+  ReadValue(in, grid.width_);
+  ReadValue(in, grid.height_);
+  if (grid.width_ <= 0 || grid.height_ <= 0 || grid.width_ * grid.height_ > kMaxCheckCount) {
+    throw std::runtime_error("broken grid file");
+  }
+  grid.cell_ids_.resize(grid.width_ * grid.height_);
+  if (!in.read(reinterpret_cast<char*>(grid.cell_ids_.data()), grid.cell_ids_.size() * sizeof(int))) {
+    throw std::runtime_error("unexpected end of grid file");
+  }
+  grid.BuildGraph();
+  return grid;
+}
+
+uint64_t FindRouteGrid::MakeKey(const common::Polygon& polygon, double step) {
+  common::Hasher hasher;
+  return AddPolygon(hasher, polygon, step).Get();
+}
+
+uint64_t FindRouteGrid::MakeKey(const common::Polygon& polygon,
+                                const std::vector<common::Segment>& corridor,
+                                double buffer, double step) {
+  common::Hasher hasher;
+  AddPolygon(hasher, polygon, step).Add(buffer);
+  for (const auto& segment : corridor) {
+    hasher.Add(segment.Start).Add(segment.End);
+  }
+  return hasher.Get();
+}
+
+std::optional<int> FindRouteGrid::GetPointId(common::Point point) const {
+  const int64_t x = std::llround(point.X() / step_) - min_x_;
+  const int64_t y = std::llround(point.Y() / step_) - min_y_;
+  if (x < 0 || x >= width_ || y < 0 || y >= height_) {
+    return std::nullopt;
+  }
+  const int id = cell_ids_[x * height_ + y];
+  if (id == -1) {
+    return std::nullopt;
+  }
+  return id;
+}
+
 }  // namespace marine_navi::entities
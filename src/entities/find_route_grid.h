@@ -1,5 +1,9 @@
 #pragma once
 
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
 #include <vector>
 
 #include "common/geom.h"
@@ -9,16 +13,47 @@ namespace marine_navi::entities {
 class FindRouteGrid {
 public:
     FindRouteGrid(const common::Polygon& polygon, double step);
+    // Grid of the polygon cells which are not further than buffer from any corridor segment, the buffer is in
+    // degrees of latitude and is widened to the east and west with latitude
+    FindRouteGrid(const common::Polygon& polygon,
+                  const std::vector<common::Segment>& corridor,
+                  double buffer, double step);
 
     const std::vector<common::Point>& GetPoints() const { return points_; }
     common::Point GetPoint(size_t id) const { return points_.at(id); }
     std::vector<common::Point> GetAdjencyPoints(int point_id) const;
     const std::vector<int>& GetAdjencyPointIds(int point_id) const { return adjacency_list_.at(point_id); }
     int GetClosestPointId(common::Point point) const;
+    // @return id of the grid node in the cell of the point, std::nullopt if the cell is outside of grid
+    std::optional<int> GetPointId(common::Point point) const;
+    size_t GetMemoryUsage() const;
+
+    void Save(std::ostream& out) const;
+    static FindRouteGrid Load(std::istream& in);
+
+    // @return key which is equal for polygons giving the same grid regardless of vertex order and orientation
+    static uint64_t MakeKey(const common::Polygon& polygon, double step);
+    static uint64_t MakeKey(const common::Polygon& polygon,
+                            const std::vector<common::Segment>& corridor,
+                            double buffer, double step);
+
+private:
+    FindRouteGrid() = default;
+
+    void ResetCells(int64_t min_x, int64_t max_x, int64_t min_y, int64_t max_y);
+    // assigns ids to marked cells and links neighbour cells
+    void BuildGraph();
 
 private:
     std::vector<std::vector<int> > adjacency_list_;
     std::vector<common::Point> points_;
+
+    double step_;
+    int64_t min_x_;
+    int64_t min_y_;
+    int64_t width_;
+    int64_t height_;
+    std::vector<int> cell_ids_;  // dense (x, y) -> point id, -1 for cells outside of grid
 };
 
 } // namespace marine_navi::entities
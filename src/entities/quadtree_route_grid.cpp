@@ -0,0 +1,147 @@
+#include "quadtree_route_grid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace marine_navi::entities {
+
+namespace {
+
+const int64_t kMaxCheckCount = 1000000;
+const int64_t kMaxVertexCount = 10000;
+
+int64_t FloorDiv(int64_t value, int64_t divisor) {
+  return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+}  // namespace
+
+QuadtreeRouteGrid::QuadtreeRouteGrid(const common::Polygon& polygon, double step, int max_level,
+                                     const SplitPredicate& need_split)
+    : step_(step) {
+  const int64_t root_size = int64_t{1} << max_level;
+
+  int64_t min_x = std::numeric_limits<int64_t>::max(), max_x = std::numeric_limits<int64_t>::min();
+  int64_t min_y = std::numeric_limits<int64_t>::max(), max_y = std::numeric_limits<int64_t>::min();
+  for (const auto& point : polygon.Points) {
+    min_x = std::min(min_x, static_cast<int64_t>(std::floor(point.X() / step)));
+    max_x = std::max(max_x, static_cast<int64_t>(std::floor(point.X() / step)));
+    min_y = std::min(min_y, static_cast<int64_t>(std::floor(point.Y() / step)));
+    max_y = std::max(max_y, static_cast<int64_t>(std::floor(point.Y() / step)));
+  }
+  // root cells are aligned, so cells of the same size from neighbour roots line up
+  min_x_ = FloorDiv(min_x, root_size) * root_size;
+  min_y_ = FloorDiv(min_y, root_size) * root_size;
+  width_ = (FloorDiv(max_x, root_size) + 1) * root_size - min_x_;
+  height_ = (FloorDiv(max_y, root_size) + 1) * root_size - min_y_;
+
+  if (polygon.Points.empty() || width_ > kMaxCheckCount || height_ > kMaxCheckCount ||
+      width_ * height_ > kMaxCheckCount) {
+    throw std::runtime_error("number points for check is too big");
+  }
+
+  cell_ids_.assign(width_ * height_, -1);
+  for (int64_t x = 0; x < width_; x += root_size) {
+    for (int64_t y = 0; y < height_; y += root_size) {
+      Split(polygon, Cell{x, y, root_size}, need_split);
+    }
+  }
+  BuildGraph();
+}
+
+void QuadtreeRouteGrid::Split(const common::Polygon& polygon, const Cell& cell, const SplitPredicate& need_split) {
+  const auto center = GetCenter(cell);
+  if (cell.size > 1) {
+    // cells crossing the zone border are split to keep the zone covered
+    bool crosses_border = false;
+    const bool center_inside = common::IsInsidePolygon(center, polygon);
+    for (const int64_t dx : {int64_t{0}, cell.size - 1}) {
+      for (const int64_t dy : {int64_t{0}, cell.size - 1}) {
+        const common::Point corner{(min_y_ + cell.y + dy) * step_, (min_x_ + cell.x + dx) * step_};
+        crosses_border |= common::IsInsidePolygon(corner, polygon) != center_inside;
+      }
+    }
+    if (crosses_border || (center_inside && need_split(center, cell.size * step_))) {
+      const int64_t half = cell.size / 2;
+      for (const int64_t dx : {int64_t{0}, half}) {
+        for (const int64_t dy : {int64_t{0}, half}) {
+          Split(polygon, Cell{cell.x + dx, cell.y + dy, half}, need_split);
+        }
+      }
+      return;
+    }
+  }
+
+  if (!common::IsInsidePolygon(center, polygon)) {
+    return;
+  }
+  if (static_cast<int64_t>(cells_.size()) >= kMaxVertexCount) {
+    throw std::runtime_error("number points is too big");
+  }
+  const int id = cells_.size();
+  cells_.push_back(cell);
+  points_.push_back(center);
+  for (int64_t x = cell.x; x < cell.x + cell.size; ++x) {
+    std::fill_n(cell_ids_.begin() + x * height_ + cell.y, cell.size, id);
+  }
+}
+
+common::Point QuadtreeRouteGrid::GetCenter(const Cell& cell) const {
+  // a cell of the finest level is centered at its lattice point like in FindRouteGrid
+  const double offset = (cell.size - 1) / 2.0;
+  return common::Point{(min_y_ + cell.y + offset) * step_, (min_x_ + cell.x + offset) * step_};
+}
+
+void QuadtreeRouteGrid::BuildGraph() {
+  if (points_.empty()) {
+    throw std::runtime_error("no points");
+  }
+
+  adjacency_list_.resize(points_.size());
+  for (size_t id = 0; id < cells_.size(); ++id) {
+    const auto& cell = cells_[id];
+    auto& adjency_ids = adjacency_list_[id];
+    // finest cells around the cell, a larger neighbour is met several times
+    auto add_neighbour = [&](int64_t x, int64_t y) {
+      if (x < 0 || x >= width_ || y < 0 || y >= height_) {
+        return;
+      }
+      const int adjency_id = cell_ids_[x * height_ + y];
+      if (adjency_id != -1 && (adjency_ids.empty() || adjency_ids.back() != adjency_id) &&
+          std::find(adjency_ids.begin(), adjency_ids.end(), adjency_id) == adjency_ids.end()) {
+        adjency_ids.push_back(adjency_id);
+      }
+    };
+    for (int64_t x = cell.x - 1; x <= cell.x + cell.size; ++x) {
+      add_neighbour(x, cell.y - 1);
+      add_neighbour(x, cell.y + cell.size);
+    }
+    for (int64_t y = cell.y; y < cell.y + cell.size; ++y) {
+      add_neighbour(cell.x - 1, y);
+      add_neighbour(cell.x + cell.size, y);
+    }
+  }
+}
+
+int QuadtreeRouteGrid::GetClosestPointId(common::Point point) const {
+  const int64_t x = static_cast<int64_t>(std::llround(point.X() / step_)) - min_x_;
+  const int64_t y = static_cast<int64_t>(std::llround(point.Y() / step_)) - min_y_;
+  if (x >= 0 && x < width_ && y >= 0 && y < height_ && cell_ids_[x * height_ + y] != -1) {
+    return cell_ids_[x * height_ + y];
+  }
+
+  double min_distance = common::GetHaversineDistance(point, points_[0]);
+  int result = 0;
+  for (size_t i = 1; i < points_.size(); ++i) {
+    const double distance = common::GetHaversineDistance(point, points_[i]);
+    if (distance < min_distance) {
+      min_distance = distance;
+      result = i;
+    }
+  }
+  return result;
+}
+
+}  // namespace marine_navi::entities
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "common/geom.h"
+
+namespace marine_navi::entities {
+
+// Route search graph over quadtree cells, coarse cells are split only where need_split asks for it.
+// Nodes are cell centers on the lattice of the finest step, neighbours are cells touching by side or corner.
+class QuadtreeRouteGrid {
+public:
+    // @param need_split is called with center and size in degrees of a cell larger than step
+    using SplitPredicate = std::function<bool(common::Point center, double size)>;
+
+    QuadtreeRouteGrid(const common::Polygon& polygon, double step, int max_level,
+                      const SplitPredicate& need_split);
+
+    const std::vector<common::Point>& GetPoints() const { return points_; }
+    const std::vector<int>& GetAdjencyPointIds(int point_id) const { return adjacency_list_.at(point_id); }
+    int GetClosestPointId(common::Point point) const;
+
+private:
+    struct Cell {
+        int64_t x;
+        int64_t y;
+        int64_t size;
+    };
+
+    void Split(const common::Polygon& polygon, const Cell& cell, const SplitPredicate& need_split);
+    common::Point GetCenter(const Cell& cell) const;
+    void BuildGraph();
+
+private:
+    std::vector<std::vector<int> > adjacency_list_;
+    std::vector<common::Point> points_;
+    std::vector<Cell> cells_;
+
+    double step_;
+    int64_t min_x_;
+    int64_t min_y_;
+    int64_t width_;
+    int64_t height_;
+    std::vector<int> cell_ids_;  // dense finest (x, y) -> id of the cell covering it, -1 outside of grid
+};
+
+}  // namespace marine_navi::entities
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+#include "common/geom.h"
+
+namespace marine_navi::entities {
+
+// Regular lat/lon raster, row 0 is the southern one
+struct RasterGeometry {
+  double min_lat;
+  double min_lon;
+  double cell_size;  // degrees
+  uint32_t n_rows;
+  uint32_t n_cols;
+
+  double GetMaxLat() const { return min_lat + cell_size * n_rows; }
+  double GetMaxLon() const { return min_lon + cell_size * n_cols; }
+
+  // @return fractional (row, col) coordinates of point, may be outside of raster
+  std::pair<double, double> ToCellCoordinates(common::Point point) const {
+    double lon = point.Lon;
+    if (GetMaxLon() > 180 && lon < 0) {
+      lon += 360;
+    }
+    return {(point.Lat - min_lat) / cell_size, (lon - min_lon) / cell_size};
+  }
+
+  // @return (row, col) of cell containing point, std::nullopt if point is outside of raster
+  std::optional<std::pair<uint32_t, uint32_t>> GetCell(common::Point point) const {
+    static constexpr double kCellEps = 1e-6;  // depth points lie exactly on cell corners
+    const auto [row, col] = ToCellCoordinates(point);
+    const double r = std::floor(row + kCellEps);
+    const double c = std::floor(col + kCellEps);
+    if (r < 0 || r >= n_rows || c < 0 || c >= n_cols) {
+      return std::nullopt;
+    }
+    return std::make_pair(static_cast<uint32_t>(r), static_cast<uint32_t>(c));
+  }
+};
+
+}  // namespace marine_navi::entities
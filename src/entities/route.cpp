@@ -1,5 +1,8 @@
 #include "route.h"
 
+#include <algorithm>
+#include <limits>
+
 namespace marine_navi::entities {
 
 Route::Route(std::vector<PlugIn_Waypoint> waypoints) : waypoints_(waypoints), total_distance_(0) {
@@ -10,39 +13,77 @@ Route::Route(std::vector<PlugIn_Waypoint> waypoints) : waypoints_(waypoints), to
     };
 
     if (i != 0) {
-      total_distance_ += common::GetHaversineDistance(
-        points_.back().point, waypoint
-      );
+      const auto segment = common::Segment{points_.back().point, waypoint};
+      const double length = common::GetHaversineDistance(segment);
+      segments_.push_back(RouteSegment{
+        .segment = segment,
+        .length = length,
+        .distance_from_start_route = total_distance_,
+      });
+      total_distance_ += length;
     }
     points_.push_back(RoutePoint{waypoint, i, total_distance_, 0});
   }
+}
 
-  for(size_t i = 0; i + 1 < waypoints.size(); ++i) {
-    segments_.push_back(RouteSegment{common::Segment{
-      points_[i].point,
-      points_[i + 1].point
-    }});
+size_t Route::FindSegmentId(double len) const {
+  // first segment which ends not before len
+  const auto it = std::lower_bound(segments_.begin(), segments_.end(), len,
+    [](const RouteSegment& segment, double value) {
+      return segment.distance_from_start_route + segment.length < value;
+    });
+  if (it == segments_.end()) {
+    return segments_.size() - 1;
   }
+  return it - segments_.begin();
 }
 
-RoutePoint Route::GetPointFromStart(double len) {
-  double pref = 0;
-  for (size_t i = 0; i < segments_.size(); ++i) {
-    double dist = common::GetHaversineDistance(segments_[i].segment);
-    if (len <= pref + dist) {
-      auto vec = points_[i + 1].point - points_[i].point;
-      double k = (len - pref) / dist;
-      return RoutePoint{
-        segments_[i].segment.Start + vec * k,
-        i,
-        len,
-        len - pref
-      };
-    }
-    pref += dist;
+RoutePoint Route::MakePoint(size_t segment_id, double len) const {
+  const auto& segment = segments_[segment_id];
+  const double offset = std::clamp(len - segment.distance_from_start_route, 0.0, segment.length);
+  const double k = segment.length > 0 ? offset / segment.length : 0;
+  const auto vec = segment.segment.End - segment.segment.Start;
+  return RoutePoint{
+    segment.segment.Start + vec * k,
+    segment_id,
+    segment.distance_from_start_route + offset,
+    offset
+  };
+}
+
+RoutePoint Route::GetPointFromStart(double len) const {
+  if (segments_.empty()) {
+    return points_.back();
   }
+  return MakePoint(FindSegmentId(len), len);
+}
 
-  return points_.back();
+RoutePoint Route::GetSegmentPoint(size_t segment_id, double offset) const {
+  return MakePoint(segment_id, segments_[segment_id].distance_from_start_route + offset);
+}
+
+Route Route::GetPart(size_t first_segment, size_t last_segment) const {
+  return Route(std::vector<PlugIn_Waypoint>(waypoints_.begin() + first_segment, waypoints_.begin() + last_segment + 1));
+}
+
+double Route::GetClosestDistanceFromStart(const common::Point& point) const {
+  double best_planar_distance = std::numeric_limits<double>::max();
+  double result = 0;
+  for (const auto& segment : segments_) {
+    const double planar_distance = common::GetDistanceToSegment(point, segment.segment);
+    if (planar_distance >= best_planar_distance) {
+      continue;
+    }
+    best_planar_distance = planar_distance;
+
+    const auto direction = segment.segment.End - segment.segment.Start;
+    const double length2 = common::DotProduct(direction, direction);
+    const double k = length2 > 0
+      ? std::clamp(common::DotProduct(direction, point - segment.segment.Start) / length2, 0.0, 1.0)
+      : 0;
+    result = segment.distance_from_start_route + segment.length * k;
+  }
+  return result;
 }
 
 }  // namespace marine_navi::entities
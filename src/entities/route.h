@@ -18,6 +18,8 @@ struct RoutePoint {
 
 struct RouteSegment {
   common::Segment segment;
+  double length;
+  double distance_from_start_route;
 };
 
 class Route {
@@ -26,11 +28,21 @@ public:
   Route(std::vector<PlugIn_Waypoint> waypoints);
 
   double GetDistance() const { return total_distance_; }
-  RoutePoint GetPointFromStart(double len);
+  // @return point at len meters from the start, binary search over the cumulative segment lengths
+  RoutePoint GetPointFromStart(double len) const;
+  // @return point at offset meters from the start of the segment, the offset is clamped to the segment
+  RoutePoint GetSegmentPoint(size_t segment_id, double offset) const;
+  // @return distance from the start to the route point closest to point, closeness is planar in coordinates
+  double GetClosestDistanceFromStart(const common::Point& point) const;
+  // @return the route of segments [first_segment, last_segment), segments keep their geometry
+  Route GetPart(size_t first_segment, size_t last_segment) const;
   const std::vector<RoutePoint>& GetPoints() const { return points_; }
   const std::vector<RouteSegment>& GetSegments() const { return segments_; }
 
 private:
+  size_t FindSegmentId(double len) const;
+  RoutePoint MakePoint(size_t segment_id, double len) const;
+
   const std::vector<PlugIn_Waypoint> waypoints_;
   std::vector<RoutePoint> points_;
   std::vector<RouteSegment> segments_;
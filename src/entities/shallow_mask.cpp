@@ -0,0 +1,149 @@
+#include "shallow_mask.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "common/utils.h"
+
+namespace marine_navi::entities {
+
+namespace {
+
+constexpr size_t kWordBits = 64;
+const int64_t kFileVersion = 1;
+
+template <typename T>
+void WriteValue(std::ostream& out, const T& value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+void ReadValue(std::istream& in, T& value) {
+  if (!in.read(reinterpret_cast<char*>(&value), sizeof(value))) {
+    throw std::runtime_error("unexpected end of mask file");
+  }
+}
+
+// @return word with bits [from, to] set
+uint64_t MakeWordMask(size_t from, size_t to) {
+  const uint64_t upper = to + 1 == kWordBits ? ~0ULL : (1ULL << (to + 1)) - 1;
+  return upper & ~((1ULL << from) - 1);
+}
+
+}  // namespace
+
+ShallowMask::ShallowMask(RasterGeometry geometry, double draft)
+    : geometry_(geometry),
+      draft_(draft),
+      words_per_row_((geometry.n_cols + kWordBits - 1) / kWordBits),
+      bits_(words_per_row_ * geometry.n_rows, 0) {}
+
+void ShallowMask::SetShallow(uint32_t row, uint32_t col) {
+  bits_[row * words_per_row_ + col / kWordBits] |= 1ULL << (col % kWordBits);
+}
+
+bool ShallowMask::IsShallow(uint32_t row, uint32_t col) const {
+  return (bits_[row * words_per_row_ + col / kWordBits] >> (col % kWordBits)) & 1ULL;
+}
+
+bool ShallowMask::IsShallow(common::Point point) const {
+  const auto cell = geometry_.GetCell(point);
+  if (!cell.has_value()) {
+    return false;
+  }
+  return IsShallow(cell->first, cell->second);
+}
+
+bool ShallowMask::HasShallowInRow(uint32_t row, uint32_t col_begin, uint32_t col_end) const {
+  const uint64_t* row_bits = bits_.data() + row * words_per_row_;
+  const size_t first_word = col_begin / kWordBits;
+  const size_t last_word = col_end / kWordBits;
+  if (first_word == last_word) {
+    return row_bits[first_word] & MakeWordMask(col_begin % kWordBits, col_end % kWordBits);
+  }
+  if (row_bits[first_word] & MakeWordMask(col_begin % kWordBits, kWordBits - 1)) {
+    return true;
+  }
+  for (size_t word = first_word + 1; word < last_word; ++word) {
+    if (row_bits[word] != 0) {
+      return true;
+    }
+  }
+  return row_bits[last_word] & MakeWordMask(0, col_end % kWordBits);
+}
+
+bool ShallowMask::IsSegmentClear(common::Point start, common::Point end) const {
+  auto [row0, col0] = geometry_.ToCellCoordinates(start);
+  auto [row1, col1] = geometry_.ToCellCoordinates(end);
+  if (row0 > row1) {
+    std::swap(row0, row1);
+    std::swap(col0, col1);
+  }
+
+  const double max_row = geometry_.n_rows - 1;
+  const double max_col = geometry_.n_cols - 1;
+  const double first_row = std::max(std::floor(row0), 0.0);
+  const double last_row = std::min(std::floor(row1), max_row);
+
+  // every row crossed by segment is checked by the span of columns covered in that row
+  for (double row = first_row; row <= last_row; row += 1) {
+    double span_col0 = col0;
+    double span_col1 = col1;
+    if (row1 - row0 > common::kEps) {
+      const double k = (col1 - col0) / (row1 - row0);
+      span_col0 = col0 + k * (std::max(row0, row) - row0);
+      span_col1 = col0 + k * (std::min(row1, row + 1) - row0);
+    }
+    const double col_begin = std::max(std::floor(std::min(span_col0, span_col1)), 0.0);
+    const double col_end = std::min(std::floor(std::max(span_col0, span_col1)), max_col);
+    if (col_begin > col_end) {
+      continue;
+    }
+    if (HasShallowInRow(static_cast<uint32_t>(row), static_cast<uint32_t>(col_begin),
+                        static_cast<uint32_t>(col_end))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ShallowMask::Save(std::ostream& out) const {
+  WriteValue(out, kFileVersion);
+  WriteValue(out, geometry_.min_lat);
+  WriteValue(out, geometry_.min_lon);
+  WriteValue(out, geometry_.cell_size);
+  WriteValue(out, geometry_.n_rows);
+  WriteValue(out, geometry_.n_cols);
+  WriteValue(out, draft_);
+  out.write(reinterpret_cast<const char*>(bits_.data()), bits_.size() * sizeof(uint64_t));
+}
+
+ShallowMask ShallowMask::Load(std::istream& in) {
+  int64_t version;
+  ReadValue(in, version);
+  if (version != kFileVersion) {
+    throw std::runtime_error("unsupported mask file version");
+  }
+  RasterGeometry geometry;
+  double draft;
+  ReadValue(in, geometry.min_lat);
+  ReadValue(in, geometry.min_lon);
+  ReadValue(in, geometry.cell_size);
+  ReadValue(in, geometry.n_rows);
+  ReadValue(in, geometry.n_cols);
+  ReadValue(in, draft);
+
+  // sizes are read from the file, so a damaged one is rejected before the bits are allocated
+  const size_t words_per_row = (static_cast<size_t>(geometry.n_cols) + kWordBits - 1) / kWordBits;
+  if (common::GetRemainingSize(in) != words_per_row * geometry.n_rows * sizeof(uint64_t)) {
+    throw std::runtime_error("mask file size does not match its geometry");
+  }
+  ShallowMask mask(geometry, draft);
+  if (!in.read(reinterpret_cast<char*>(mask.bits_.data()), mask.bits_.size() * sizeof(uint64_t))) {
+    throw std::runtime_error("unexpected end of mask file");
+  }
+  return mask;
+}
+
+}  // namespace marine_navi::entities
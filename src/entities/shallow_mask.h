@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include "common/geom.h"
+#include "entities/raster_geometry.h"
+
+namespace marine_navi::entities {
+
+// Bit-packed raster of cells shallower than a draft threshold. Cells without depth data are navigable.
+class ShallowMask {
+public:
+  ShallowMask(RasterGeometry geometry, double draft);
+
+  void SetShallow(uint32_t row, uint32_t col);
+  bool IsShallow(uint32_t row, uint32_t col) const;
+  bool IsShallow(common::Point point) const;
+  // @return true if the segment does not touch any shallow cell
+  bool IsSegmentClear(common::Point start, common::Point end) const;
+
+  const RasterGeometry& GetGeometry() const { return geometry_; }
+  double GetDraft() const { return draft_; }
+
+  void Save(std::ostream& out) const;
+  static ShallowMask Load(std::istream& in);
+
+private:
+  // @return true if any cell of row in [col_begin, col_end] is shallow
+  bool HasShallowInRow(uint32_t row, uint32_t col_begin, uint32_t col_end) const;
+
+private:
+  RasterGeometry geometry_;
+  double draft_;
+  size_t words_per_row_;
+  std::vector<uint64_t> bits_;
+};
+
+}  // namespace marine_navi::entities
@@ -12,6 +12,12 @@ struct ShipPerformanceInfo {
   std::optional<double> Fullness;
   std::optional<double> Speed;
   std::optional<double> ShipDraft;
+
+  bool operator==(const ShipPerformanceInfo& other) const {
+    return DangerHeight == other.DangerHeight && EnginePower == other.EnginePower &&
+           Displacement == other.Displacement && Length == other.Length &&
+           Fullness == other.Fullness && Speed == other.Speed && ShipDraft == other.ShipDraft;
+  }
 };
 
 } // namespace marine_navi::entities
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <vector>
+
+#include "common/geom.h"
+
+namespace marine_navi::entities {
+
+// Area where depth is not enough for the draft
+struct ShoalPolygon {
+  double draft;
+  common::Polygon outer;
+  std::vector<common::Polygon> holes;
+  // max distance between simplified rings and traced isobath
+  double tolerance;
+};
+
+}  // namespace marine_navi::entities
@@ -0,0 +1,155 @@
+#include "visibility_graph.h"
+
+#include <algorithm>
+
+namespace marine_navi::entities {
+
+namespace {
+
+struct Bounds {
+  double min_x, min_y, max_x, max_y;
+
+  bool Intersects(const Bounds& other) const {
+    return min_x <= other.max_x && other.min_x <= max_x && min_y <= other.max_y && other.min_y <= max_y;
+  }
+};
+
+Bounds GetBounds(const common::Segment& segment) {
+  return Bounds{
+    std::min(segment.Start.X(), segment.End.X()), std::min(segment.Start.Y(), segment.End.Y()),
+    std::max(segment.Start.X(), segment.End.X()), std::max(segment.Start.Y(), segment.End.Y()),
+  };
+}
+
+Bounds GetBounds(const common::Polygon& ring) {
+  Bounds bounds{ring.Points[0].X(), ring.Points[0].Y(), ring.Points[0].X(), ring.Points[0].Y()};
+  for (const auto& point : ring.Points) {
+    bounds.min_x = std::min(bounds.min_x, point.X());
+    bounds.min_y = std::min(bounds.min_y, point.Y());
+    bounds.max_x = std::max(bounds.max_x, point.X());
+    bounds.max_y = std::max(bounds.max_y, point.Y());
+  }
+  return bounds;
+}
+
+class Ring {
+public:
+  Ring(const common::Polygon& polygon) : polygon_(polygon), bounds_(GetBounds(polygon)) {}
+
+  bool IsCrossedBy(const common::Segment& segment, const Bounds& segment_bounds) const {
+    if (!bounds_.Intersects(segment_bounds)) {
+      return false;
+    }
+    const auto& points = polygon_.Points;
+    for (size_t i = 0; i < points.size(); ++i) {
+      if (common::IsSegmentsCrossing(segment, {points[i], points[(i + 1) % points.size()]})) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool Contains(const common::Point& point) const {
+    return bounds_.Intersects(Bounds{point.X(), point.Y(), point.X(), point.Y()}) &&
+           common::IsInsidePolygon(point, polygon_);
+  }
+
+private:
+  const common::Polygon& polygon_;
+  Bounds bounds_;
+};
+
+}  // namespace
+
+std::optional<VisibilityGraph> VisibilityGraph::Build(const common::Polygon& zone,
+                                                      const std::vector<ShoalPolygon>& obstacles,
+                                                      common::Point start, common::Point end,
+                                                      size_t max_vertex_count) {
+  VisibilityGraph graph;
+  graph.points_ = {start, end};
+
+  std::vector<Ring> rings;
+  // outer ring index and its holes, a point is blocked if it is inside outer and not inside any hole
+  std::vector<std::pair<size_t, std::vector<size_t>>> shoals;
+  // for obstacle vertices: shoal index and neighbour vertices on the same ring
+  std::vector<std::optional<size_t>> point_shoals = {std::nullopt, std::nullopt};
+  std::vector<std::pair<size_t, size_t>> ring_neighbours = {{0, 0}, {1, 1}};
+
+  auto add_ring = [&](const common::Polygon& ring) {
+    const size_t offset = graph.points_.size();
+    const size_t size = ring.Points.size();
+    rings.emplace_back(ring);
+    for (size_t i = 0; i < size; ++i) {
+      graph.points_.push_back(ring.Points[i]);
+      point_shoals.push_back(shoals.size() - 1);
+      ring_neighbours.push_back({offset + (i + size - 1) % size, offset + (i + 1) % size});
+    }
+  };
+
+  for (const auto& obstacle : obstacles) {
+    if (obstacle.outer.Points.size() < 3) {
+      continue;
+    }
+    shoals.push_back({rings.size(), {}});
+    add_ring(obstacle.outer);
+    for (const auto& hole : obstacle.holes) {
+      if (hole.Points.size() < 3) {
+        continue;
+      }
+      shoals.back().second.push_back(rings.size());
+      add_ring(hole);
+    }
+    if (graph.points_.size() > max_vertex_count + 2) {
+      return std::nullopt;
+    }
+  }
+  const Ring zone_ring(zone);
+
+  // points on the boundary of a shoal are checked against other shoals only
+  auto is_blocked = [&](const common::Point& point, std::optional<size_t> skip_shoal) {
+    if (!zone_ring.Contains(point)) {
+      return true;
+    }
+    for (size_t i = 0; i < shoals.size(); ++i) {
+      const auto& [outer, holes] = shoals[i];
+      if (skip_shoal != i && rings[outer].Contains(point) &&
+          std::none_of(holes.begin(), holes.end(), [&](size_t hole) { return rings[hole].Contains(point); })) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  std::vector<bool> blocked(graph.points_.size());
+  for (size_t i = 0; i < graph.points_.size(); ++i) {
+    blocked[i] = is_blocked(graph.points_[i], point_shoals[i]);
+  }
+
+  graph.adjacency_list_.resize(graph.points_.size());
+  for (size_t i = 0; i < graph.points_.size(); ++i) {
+    if (blocked[i]) {
+      continue;
+    }
+    for (size_t j = i + 1; j < graph.points_.size(); ++j) {
+      if (blocked[j]) {
+        continue;
+      }
+      const common::Segment segment{graph.points_[i], graph.points_[j]};
+      const auto segment_bounds = GetBounds(segment);
+      // edges of a ring go along the shoal boundary, any other edge is blocked if its middle point
+      // is inside of a shoal, it catches edges going through an obstacle between two of its vertices
+      const bool is_ring_edge = ring_neighbours[i].first == j || ring_neighbours[i].second == j;
+      if ((!is_ring_edge && is_blocked((segment.Start + segment.End) * 0.5, std::nullopt)) ||
+          zone_ring.IsCrossedBy(segment, segment_bounds) ||
+          std::any_of(rings.begin(), rings.end(),
+                      [&](const Ring& ring) { return ring.IsCrossedBy(segment, segment_bounds); })) {
+        continue;
+      }
+      graph.adjacency_list_[i].push_back(j);
+      graph.adjacency_list_[j].push_back(i);
+    }
+  }
+  return graph;
+}
+
+}  // namespace marine_navi::entities
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <optional>
+#include <vector>
+
+#include "common/geom.h"
+#include "entities/shoal_polygon.h"
+
+namespace marine_navi::entities {
+
+// Graph over start, end and obstacle vertices where edges are straight lines which stay
+// inside of the zone and do not pass through obstacles
+class VisibilityGraph {
+public:
+    // @return std::nullopt if there are more obstacle vertices than max_vertex_count
+    static std::optional<VisibilityGraph> Build(const common::Polygon& zone,
+                                                const std::vector<ShoalPolygon>& obstacles,
+                                                common::Point start, common::Point end,
+                                                size_t max_vertex_count);
+
+    const std::vector<common::Point>& GetPoints() const { return points_; }
+    const std::vector<int>& GetAdjencyPointIds(int point_id) const { return adjacency_list_.at(point_id); }
+    int GetStartPointId() const { return 0; }
+    int GetEndPointId() const { return 1; }
+
+private:
+    VisibilityGraph() = default;
+
+private:
+    std::vector<common::Point> points_;
+    std::vector<std::vector<int> > adjacency_list_;
+};
+
+}  // namespace marine_navi::entities
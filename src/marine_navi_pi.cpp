@@ -1,5 +1,7 @@
 #include "marine_navi_pi.h"
 
+#include <cmath>
+
 #include "wx/wx.h"
 #include <wx/fileconf.h>
 #include <wx/stdpaths.h>
@@ -99,7 +101,8 @@ int MarineNaviPi::Init(void) {
 
   return (WANTS_OVERLAY_CALLBACK | WANTS_OPENGL_OVERLAY_CALLBACK |
           WANTS_TOOLBAR_CALLBACK | INSTALLS_TOOLBAR_TOOL |
-          WANTS_PLUGIN_MESSAGING | WANTS_VECTOR_CHART_OBJECT_INFO);
+          WANTS_NMEA_EVENTS | WANTS_PLUGIN_MESSAGING |
+          WANTS_VECTOR_CHART_OBJECT_INFO);
 
   // return (WANTS_OVERLAY_CALLBACK | WANTS_OPENGL_OVERLAY_CALLBACK |
   //         WANTS_TOOLBAR_CALLBACK | INSTALLS_TOOLBAR_TOOL |
@@ -147,6 +150,15 @@ wxString MarineNaviPi::GetShortDescription() { return PKG_SUMMARY; }
 
 wxString MarineNaviPi::GetLongDescription() { return PKG_DESCRIPTION; }
 
+void MarineNaviPi::SetPositionFixEx(PlugIn_Position_Fix_Ex& pfix) {
+  // the position is NaN while there is no fix
+  if (std::isnan(pfix.Lat) || std::isnan(pfix.Lon)) {
+    return;
+  }
+  deps_.marine_route_scanner->UpdateOwnShipPosition(
+      marine_navi::common::Point{pfix.Lat, pfix.Lon}, pfix.FixTime);
+}
+
 void MarineNaviPi::OnToolbarToolCallback(int id) {
   if (!dlg_) {
     dlg_ = std::make_shared<marine_navi::dialogs::MarineNaviMainDlg>(
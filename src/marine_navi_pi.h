@@ -90,6 +90,8 @@ public:
             chartStr, featureStr, objnameStr, lat, lon, scale, nativescale);
   }
 
+  void SetPositionFixEx(PlugIn_Position_Fix_Ex &pfix) override;
+
   int GetToolbarToolCount(void) { return 1; }
   void OnToolbarToolCallback(int id);
 
@@ -4,41 +4,43 @@ namespace marine_navi {
 
 RenderOverlay::RenderOverlay(Dependencies& deps)
     : checkPathCase_(deps.marine_route_scanner),
+      rendered_version_(0),
+      rendered_partial_(false),
+      rendered_detection_id_(0),
+      rendered_hazard_count_(0),
       canvas_window_(deps.ocpn_canvas_window) {}
 
 bool RenderOverlay::Render(piDC& dc, PlugIn_ViewPort* vp) {
-  if (checkPathCase_->IsShow()) {
-    auto pathData = checkPathCase_->GetPathData();
-    RenderCheckPath(dc, vp, pathData);
-    return true;
+  const auto snapshot = checkPathCase_->GetSnapshot();
+  if (snapshot->version != rendered_version_) {
+    SyncHazardWaypoints(*snapshot);
+    rendered_version_ = snapshot->version;
   }
-  return false;
+  return snapshot->show;
 }
 
-void RenderOverlay::RenderCheckPath(piDC& dc, PlugIn_ViewPort* vp,
-                                    const cases::RouteScannerInput& pathData) {
-  dc.SetPen(*wxBLACK);                // reset pen
-  dc.SetBrush(*wxTRANSPARENT_BRUSH);  // reset brush
-  dc.SetPen(wxPen(wxColor(0, 0, 0)));
-  wxPen pen = dc.GetPen();
-  pen.SetWidth(5);
-  dc.SetPen(pen);
-
-  auto cross = checkPathCase_->GetDiagnostic();
-
+void RenderOverlay::SyncHazardWaypoints(const cases::RouteScannerSnapshot& snapshot) {
   const std::string kPrefixGuid = "hazard_points_";
 
-  auto guids = GetWaypointGUIDArray();
-  for(auto& guid : guids) {
-    wxLogInfo(_T("guid waypoint '%s'"), guid.ToStdString().c_str());
-    if (guid.Contains(kPrefixGuid)) {
-      DeleteSingleWaypoint(guid);
+  // a streamed detection only appends hazards until it completes
+  const bool is_continued = snapshot.show && snapshot.partial && rendered_partial_ &&
+                            snapshot.detection_id == rendered_detection_id_;
+  if (!is_continued) {
+    auto guids = GetWaypointGUIDArray();
+    for(auto& guid : guids) {
+      if (guid.Contains(kPrefixGuid)) {
+        DeleteSingleWaypoint(guid);
+      }
     }
+    rendered_hazard_count_ = 0;
   }
+  rendered_partial_ = snapshot.show && snapshot.partial;
+  rendered_detection_id_ = snapshot.detection_id;
 
-  if (cross.has_value() && cross->result == entities::diagnostic::RouteValidateDiagnostic::DiagnosticResultType::kWarning) {
-    wxPoint2DDouble crossCenter;
-    for(size_t i = 0; i < cross->hazard_points.size(); ++i) {
+  const auto& cross = snapshot.diagnostic;
+  if (snapshot.show && cross != nullptr &&
+      cross->result == entities::diagnostic::RouteValidateDiagnostic::DiagnosticResultType::kWarning) {
+    for(size_t i = rendered_hazard_count_; i < cross->hazard_points.size(); ++i) {
       const auto& hazard_point = cross->hazard_points[i];
       const auto location = hazard_point.GetLocation();
       const wxString guid = kPrefixGuid + std::to_string(i);
@@ -47,6 +49,7 @@ void RenderOverlay::RenderCheckPath(piDC& dc, PlugIn_ViewPort* vp,
       waypoint.RangeRingColor = wxColor(255, 0, 0);
       AddSingleWaypointEx(&waypoint, false);
     }
+    rendered_hazard_count_ = cross->hazard_points.size();
   }
 }
 
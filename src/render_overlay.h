@@ -19,12 +19,19 @@ public:
   void RenderBestPath(PlugIn_Route_Ex* route_ex);
 
 private:
-  void RenderCheckPath(piDC& dc, PlugIn_ViewPort* vp, const cases::RouteScannerInput& pathData);
+  // hazard waypoints are recreated only when the scanner publishes a new snapshot,
+  // hazards streamed by a detection are added to the rendered ones
+  void SyncHazardWaypoints(const cases::RouteScannerSnapshot& snapshot);
 
 private:
   std::shared_ptr<cases::MarineRouteScanner> checkPathCase_;
 
   std::optional<wxPoint2DDouble> checkPathResult_;
+  uint64_t rendered_version_;
+  // the rendered snapshot was a part of a streamed detection
+  bool rendered_partial_;
+  uint64_t rendered_detection_id_;
+  size_t rendered_hazard_count_;
   wxWindow* canvas_window_;
 };
 